@@ -0,0 +1,681 @@
+/*
+* >> srxk.hpp 0.1.0
+* C++ class templates for the srxk containers
+* The C headers have to be instantiated once per type with macros and copy
+* everything in and out by value, these do the same job for any T. They use
+* the same growth, hashing and gap logic as the C headers
+*
+* >> Usage
+* ```
+* #include <srxk.hpp>
+*
+* srxk::vector<std::string> v;
+* v.emplace_back(16, 'x');
+* srxk::hashtable<std::string, int> ht;
+* ht.try_emplace("key", 1);
+* int *x = ht.find(std::string_view("key"));
+* ```
+* Containers own their elements and can be moved but not copied. Trivially
+* copyable types are moved around with memcpy/realloc, everything else is
+* move constructed. Running out of memory throws std::bad_alloc, reading out
+* of bounds with at() throws std::out_of_range
+*
+* Requires C++17
+*
+* >> License
+* Be Nice Please Public License
+* Version 2, FEBUARY 2020
+*
+* Copyright (C) 2020 Milo Wheeler <milowheeler@protonmail.com>
+*
+* Permission is granted, free of charge, to any person obtaining a copy of this
+* "Software", to the rights to, use, copy, modify, merge, publish, distribute,
+* and/or sell copies of the Software without restriction, this holds true as
+* long as the software is not used to intentionally hurt people, and/or
+* communities emotionally or physically.
+*
+* Due to the nature of Open Source, no liability or warranty of any kind is
+* provided with this Software.
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*/
+
+#ifndef SRXK_HPP
+#define SRXK_HPP
+
+// INCLUDES
+#include <cstddef> // std::size_t, std::max_align_t
+#include <cstdint> // std::uint64_t
+#include <cstdlib> // std::malloc, std::realloc, std::free
+#include <cstring> // std::memcpy, std::memmove
+#include <functional> // std::hash
+#include <new> // placement new, std::bad_alloc
+#include <stdexcept> // std::out_of_range
+#include <string_view> // std::string_view
+#include <type_traits> // std::is_trivially_copyable_v
+#include <utility> // std::move, std::forward, std::pair
+
+namespace srxk {
+
+// CONSTANTS
+// These match srxk_vector.h, srxk_hashtable.h and srxk_gapbuffer.h
+namespace detail {
+constexpr std::size_t vector_start_length = 4;
+constexpr std::size_t vector_growth_factor = 2;
+constexpr std::size_t vector_growth_cap = 32768;
+constexpr std::size_t vector_growth_cap_growth = 4096;
+constexpr std::size_t ht_start_capacity = 53;
+constexpr std::size_t ht_max_load = 70;
+constexpr std::size_t gapbuffer_grow_size = 10;
+}
+
+// HELPERS
+// You shouldn't be calling these for any good reason
+namespace detail {
+
+template <class T>
+T *allocate(std::size_t n)
+{
+	static_assert(alignof(T) <= alignof(std::max_align_t),
+			"over aligned types aren't supported");
+	if (n == 0)
+		return nullptr;
+	void *p = std::malloc(sizeof(T) * n);
+	if (p == nullptr)
+		throw std::bad_alloc();
+	return static_cast<T*>(p);
+}
+
+/*Moves n elements into uninitialised memory and destroys the originals, the
+ranges are allowed to overlap*/
+template <class T>
+void relocate(T *dst, T *src, std::size_t n)
+{
+	if constexpr (std::is_trivially_copyable_v<T>) {
+		if (n != 0)
+			std::memmove(static_cast<void*>(dst), src, sizeof(T) * n);
+	} else if (dst < src) {
+		for (std::size_t i = 0; i < n; ++i) {
+			::new (static_cast<void*>(dst + i)) T(std::move(src[i]));
+			src[i].~T(); }
+	} else if (dst > src) {
+		for (std::size_t i = n; i-- > 0;) {
+			::new (static_cast<void*>(dst + i)) T(std::move(src[i]));
+			src[i].~T(); }
+	}
+}
+
+template <class T>
+void destroy(T *p, std::size_t n)
+{
+	if constexpr (!std::is_trivially_destructible_v<T>)
+		for (std::size_t i = 0; i < n; ++i)
+			p[i].~T();
+}
+
+/*Moves len elements into a buffer of cap elements, realloc is used when the
+type allows it so the data might not have to move at all*/
+template <class T>
+T *reallocate(T *data, std::size_t len, std::size_t cap)
+{
+	if constexpr (std::is_trivially_copyable_v<T>) {
+		void *p = std::realloc(data, sizeof(T) * cap);
+		if (p == nullptr)
+			throw std::bad_alloc();
+		return static_cast<T*>(p);
+	} else {
+		T *p = allocate<T>(cap);
+		relocate(p, data, len);
+		std::free(data);
+		return p;
+	}
+}
+
+/*Strings of any kind hash as std::string_view, so a std::string key can be
+looked up with a std::string_view or const char* without allocating*/
+template <class Q>
+std::uint64_t hash_key(const Q &k)
+{
+	std::uint64_t h;
+	if constexpr (std::is_convertible_v<const Q&, std::string_view>)
+		h = std::hash<std::string_view>{}(std::string_view(k));
+	else
+		h = std::hash<Q>{}(k);
+	// std::hash is often the identity, so mix it before it is used
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	return h;
+}
+
+inline std::size_t next_prime(std::size_t n)
+{
+	if (n < 3)
+		return 3;
+	n |= 1;
+	for (;; n += 2)
+	{
+		bool prime = true;
+		for (std::size_t d = 3; d <= n / d; d += 2)
+			if (n % d == 0) {
+				prime = false;
+				break; }
+		if (prime)
+			return n;
+	}
+}
+
+} // namespace detail
+
+// VECTOR
+template <class T>
+class vector
+{
+public:
+	vector() = default;
+	vector(const vector&) = delete;
+	vector &operator=(const vector&) = delete;
+	vector(vector &&o) noexcept
+		: data_(o.data_), len_(o.len_), cap_(o.cap_)
+	{
+		o.data_ = nullptr;
+		o.len_ = o.cap_ = 0;
+	}
+	vector &operator=(vector &&o) noexcept
+	{
+		if (this != &o) {
+			this->~vector();
+			::new (static_cast<void*>(this)) vector(std::move(o)); }
+		return *this;
+	}
+	~vector()
+	{
+		detail::destroy(data_, len_);
+		std::free(data_);
+	}
+
+	/*
+	* Description:
+	* 	Constructs a new item at the back of the vector
+	* Parameters:
+	* 	Args &&...args - passed to the constructor of T
+	* Return Value:
+	* 	The new item
+	*/
+	template <class... Args>
+	T &emplace_back(Args &&...args)
+	{
+		if (len_ == cap_) {
+			// args might point into the vector, so build it before growing
+			T tmp(std::forward<Args>(args)...);
+			grow();
+			::new (static_cast<void*>(data_ + len_)) T(std::move(tmp));
+		} else
+			::new (static_cast<void*>(data_ + len_))
+					T(std::forward<Args>(args)...);
+		return data_[len_++];
+	}
+	void push_back(const T &x) { emplace_back(x); }
+	void push_back(T &&x) { emplace_back(std::move(x)); }
+
+	/*
+	* Description:
+	* 	Removes the last item of the vector
+	* Parameters:
+	* 	None
+	* Return Value:
+	* 	The popped item, throws std::out_of_range if the vector is empty
+	*/
+	T pop_back()
+	{
+		if (len_ == 0)
+			throw std::out_of_range("srxk::vector::pop_back");
+		T x(std::move(data_[--len_]));
+		data_[len_].~T();
+		return x;
+	}
+
+	void reserve(std::size_t cap)
+	{
+		if (cap > cap_) {
+			data_ = detail::reallocate(data_, len_, cap);
+			cap_ = cap; }
+	}
+	void clear()
+	{
+		detail::destroy(data_, len_);
+		len_ = 0;
+	}
+
+	T &at(std::size_t i)
+	{
+		if (i >= len_)
+			throw std::out_of_range("srxk::vector::at");
+		return data_[i];
+	}
+	const T &at(std::size_t i) const
+	{
+		return const_cast<vector*>(this)->at(i);
+	}
+	T &operator[](std::size_t i) { return data_[i]; }
+	const T &operator[](std::size_t i) const { return data_[i]; }
+	T &last() { return data_[len_ - 1]; }
+	const T &last() const { return data_[len_ - 1]; }
+
+	T *data() { return data_; }
+	const T *data() const { return data_; }
+	T *begin() { return data_; }
+	T *end() { return data_ + len_; }
+	const T *begin() const { return data_; }
+	const T *end() const { return data_ + len_; }
+	std::size_t size() const { return len_; }
+	std::size_t capacity() const { return cap_; }
+	bool empty() const { return len_ == 0; }
+
+private:
+	void grow()
+	{
+		/*Same policy as srxk_vector.h when realloc can be used, otherwise
+		every element is moved on each grow so it has to stay geometric*/
+		std::size_t cap;
+		if (cap_ == 0)
+			cap = detail::vector_start_length;
+		else if (std::is_trivially_copyable_v<T> && cap_
+				* detail::vector_growth_factor > detail::vector_growth_cap)
+			cap = cap_ + detail::vector_growth_cap_growth;
+		else
+			cap = cap_ * detail::vector_growth_factor;
+		data_ = detail::reallocate(data_, len_, cap);
+		cap_ = cap;
+	}
+
+	T *data_ = nullptr;
+	std::size_t len_ = 0;
+	std::size_t cap_ = 0;
+};
+
+// HASH TABLE
+/*Open addressing with double hashing over a prime number of buckets, like
+srxk_hashtable.h, but the keys and values are stored in the buckets*/
+template <class K, class V>
+class hashtable
+{
+public:
+	hashtable() { rehash(detail::ht_start_capacity); }
+	hashtable(const hashtable&) = delete;
+	hashtable &operator=(const hashtable&) = delete;
+	hashtable(hashtable &&o) noexcept
+		: state_(o.state_), slots_(o.slots_), capacity_(o.capacity_),
+		  count_(o.count_), deleted_(o.deleted_)
+	{
+		o.state_ = nullptr;
+		o.slots_ = nullptr;
+		o.capacity_ = o.count_ = o.deleted_ = 0;
+	}
+	hashtable &operator=(hashtable &&o) noexcept
+	{
+		if (this != &o) {
+			this->~hashtable();
+			::new (static_cast<void*>(this)) hashtable(std::move(o)); }
+		return *this;
+	}
+	~hashtable()
+	{
+		for (std::size_t i = 0; i < capacity_; ++i)
+			if (state_[i] == full)
+				slots_[i].~slot();
+		std::free(state_);
+		std::free(slots_);
+	}
+
+	/*
+	* Description:
+	* 	Constructs a value in place if the key isn't in the table yet, the key
+	*  is only converted to K if it has to be stored
+	* Parameters:
+	* 	Q &&key - the key, anything K can be built from and compared with
+	* 	Args &&...args - passed to the constructor of V
+	* Return Value:
+	* 	The value stored under key, and true if it was just inserted
+	*/
+	template <class Q, class... Args>
+	std::pair<V*, bool> try_emplace(Q &&key, Args &&...args)
+	{
+		// A moved from table has no buckets until it is used again
+		if (capacity_ == 0)
+			rehash(detail::ht_start_capacity);
+		else if ((count_ + deleted_ + 1) * 100 > capacity_ * detail::ht_max_load)
+			rehash(count_ * 2 > capacity_ ? capacity_ * 2 : capacity_);
+
+		std::size_t i;
+		if (probe(key, i))
+			return {&slots_[i].value, false};
+		::new (static_cast<void*>(&slots_[i]))
+				slot(std::forward<Q>(key), std::forward<Args>(args)...);
+		if (state_[i] == deleted)
+			--deleted_;
+		state_[i] = full;
+		++count_;
+		return {&slots_[i].value, true};
+	}
+
+	template <class Q, class W>
+	V &insert_or_assign(Q &&key, W &&value)
+	{
+		auto r = try_emplace(std::forward<Q>(key), std::forward<W>(value));
+		if (!r.second)
+			*r.first = std::forward<W>(value);
+		return *r.first;
+	}
+
+	/*
+	* Description:
+	* 	Finds the value stored under a key
+	* Parameters:
+	* 	const Q &key - the key, anything that compares equal to K and hashes
+	* 	the same, e.g. a std::string_view for std::string keys
+	* Return Value:
+	* 	A pointer to the value, or nullptr if it isn't found
+	*/
+	template <class Q>
+	V *find(const Q &key)
+	{
+		std::size_t i;
+		return probe(key, i) ? &slots_[i].value : nullptr;
+	}
+	template <class Q>
+	const V *find(const Q &key) const
+	{
+		return const_cast<hashtable*>(this)->find(key);
+	}
+	template <class Q>
+	bool contains(const Q &key) const { return find(key) != nullptr; }
+
+	/*
+	* Description:
+	* 	Removes a key and its value from the table
+	* Parameters:
+	* 	const Q &key - the key to remove
+	* Return Value:
+	* 	true if the key was in the table
+	*/
+	template <class Q>
+	bool erase(const Q &key)
+	{
+		std::size_t i;
+		if (!probe(key, i))
+			return false;
+		slots_[i].~slot();
+		state_[i] = deleted;
+		--count_;
+		++deleted_;
+		return true;
+	}
+
+	std::size_t size() const { return count_; }
+	std::size_t capacity() const { return capacity_; }
+	bool empty() const { return count_ == 0; }
+
+private:
+	enum : unsigned char { empty_bucket = 0, full = 1, deleted = 2 };
+	struct slot
+	{
+		template <class Q, class... Args>
+		slot(Q &&k, Args &&...args)
+			: key(std::forward<Q>(k)), value(std::forward<Args>(args)...) {}
+		K key;
+		V value;
+	};
+
+	/*Looks for key, returns true with i set to its bucket if it is found,
+	otherwise i is set to the bucket it should be inserted into. A moved from
+	table has no buckets, so nothing is ever found in it*/
+	template <class Q>
+	bool probe(const Q &key, std::size_t &i) const
+	{
+		i = 0;
+		if (capacity_ == 0)
+			return false;
+		std::uint64_t h = detail::hash_key(key);
+		std::size_t step = (std::size_t)((h >> 32) % (capacity_ - 1)) + 1;
+		std::size_t tomb = capacity_;
+		i = (std::size_t)(h % capacity_);
+		for (std::size_t n = 0; n < capacity_; ++n)
+		{
+			if (state_[i] == empty_bucket)
+				break;
+			if (state_[i] == deleted) {
+				if (tomb == capacity_)
+					tomb = i;
+			} else if (slots_[i].key == key)
+				return true;
+			i = (i + step) % capacity_;
+		}
+		if (tomb != capacity_)
+			i = tomb;
+		return false;
+	}
+
+	void rehash(std::size_t capacity)
+	{
+		capacity = detail::next_prime(capacity);
+		unsigned char *state = static_cast<unsigned char*>(
+				std::calloc(capacity, 1));
+		if (state == nullptr)
+			throw std::bad_alloc();
+		slot *slots;
+		try {
+			slots = detail::allocate<slot>(capacity);
+		} catch (...) {
+			std::free(state);
+			throw;
+		}
+
+		// Keys are unique so they don't need comparing on the way over
+		for (std::size_t i = 0; i < capacity_; ++i)
+		{
+			if (state_[i] != full)
+				continue;
+			std::uint64_t h = detail::hash_key(slots_[i].key);
+			std::size_t step = (std::size_t)((h >> 32) % (capacity - 1)) + 1;
+			std::size_t j = (std::size_t)(h % capacity);
+			while (state[j] != empty_bucket)
+				j = (j + step) % capacity;
+			detail::relocate(&slots[j], &slots_[i], 1);
+			state[j] = full;
+		}
+
+		std::free(state_);
+		std::free(slots_);
+		state_ = state;
+		slots_ = slots;
+		capacity_ = capacity;
+		deleted_ = 0;
+	}
+
+	unsigned char *state_ = nullptr;
+	slot *slots_ = nullptr;
+	std::size_t capacity_ = 0;
+	std::size_t count_ = 0;
+	std::size_t deleted_ = 0;
+};
+
+// GAP BUFFER
+template <class T>
+class gapbuffer
+{
+public:
+	explicit gapbuffer(std::size_t size = detail::gapbuffer_grow_size)
+		: buf_(detail::allocate<T>(size)), len_(size), gap_len_(size) {}
+	gapbuffer(const gapbuffer&) = delete;
+	gapbuffer &operator=(const gapbuffer&) = delete;
+	gapbuffer(gapbuffer &&o) noexcept
+		: buf_(o.buf_), len_(o.len_), gap_strt_(o.gap_strt_),
+		  gap_len_(o.gap_len_)
+	{
+		o.buf_ = nullptr;
+		o.len_ = o.gap_strt_ = o.gap_len_ = 0;
+	}
+	gapbuffer &operator=(gapbuffer &&o) noexcept
+	{
+		if (this != &o) {
+			this->~gapbuffer();
+			::new (static_cast<void*>(this)) gapbuffer(std::move(o)); }
+		return *this;
+	}
+	~gapbuffer()
+	{
+		detail::destroy(buf_, gap_strt_);
+		detail::destroy(buf_ + gap_end(), len_ - gap_end());
+		std::free(buf_);
+	}
+
+	/*
+	* Description:
+	* 	Constructs a new element at the cursor, grows if needed
+	* Parameters:
+	* 	Args &&...args - passed to the constructor of T
+	* Return Value:
+	* 	The new element
+	*/
+	template <class... Args>
+	T &emplace(Args &&...args)
+	{
+		if (gap_len_ == 0) {
+			T tmp(std::forward<Args>(args)...);
+			grow(detail::gapbuffer_grow_size);
+			::new (static_cast<void*>(buf_ + gap_strt_)) T(std::move(tmp));
+		} else
+			::new (static_cast<void*>(buf_ + gap_strt_))
+					T(std::forward<Args>(args)...);
+		--gap_len_;
+		return buf_[gap_strt_++];
+	}
+	void insert(const T &x) { emplace(x); }
+	void insert(T &&x) { emplace(std::move(x)); }
+
+	/*
+	* Description:
+	* 	Copies an array of elements in at the cursor, grows if needed
+	* Parameters:
+	* 	const T *data - the elements to insert
+	* 	std::size_t len - how many elements to insert
+	* Return Value:
+	* 	None
+	*/
+	void insert(const T *data, std::size_t len)
+	{
+		if (gap_len_ < len)
+			grow(len);
+		if constexpr (std::is_trivially_copyable_v<T>) {
+			if (len != 0)
+				std::memcpy(static_cast<void*>(buf_ + gap_strt_), data,
+						sizeof(T) * len);
+		} else
+			for (std::size_t i = 0; i < len; ++i)
+				::new (static_cast<void*>(buf_ + gap_strt_ + i)) T(data[i]);
+		gap_strt_ += len;
+		gap_len_ -= len;
+	}
+
+	/*
+	* Description:
+	* 	Deletes elements before the cursor, like a backspace
+	* Parameters:
+	* 	std::size_t len - how many elements to delete
+	* Return Value:
+	* 	None, throws std::out_of_range if there aren't len elements before
+	*  the cursor
+	*/
+	void erase(std::size_t len = 1)
+	{
+		if (len > gap_strt_)
+			throw std::out_of_range("srxk::gapbuffer::erase");
+		gap_strt_ -= len;
+		gap_len_ += len;
+		detail::destroy(buf_ + gap_strt_, len);
+	}
+
+	void left()
+	{
+		if (gap_strt_ > 0)
+			move(gap_strt_ - 1);
+	}
+	void right()
+	{
+		if (gap_end() < len_)
+			move(gap_strt_ + 1);
+	}
+
+	/*
+	* Description:
+	* 	Moves the cursor to an index, the elements in between are moved
+	*  across the gap in one go
+	* Parameters:
+	* 	std::size_t pos - the index to move the cursor to
+	* Return Value:
+	* 	None, throws std::out_of_range if pos is past the end
+	*/
+	void move(std::size_t pos)
+	{
+		if (pos > size())
+			throw std::out_of_range("srxk::gapbuffer::move");
+		if (pos < gap_strt_)
+			detail::relocate(buf_ + pos + gap_len_, buf_ + pos, gap_strt_ - pos);
+		else
+			detail::relocate(buf_ + gap_strt_, buf_ + gap_end(), pos - gap_strt_);
+		gap_strt_ = pos;
+	}
+
+	T &operator[](std::size_t i)
+	{
+		return buf_[i < gap_strt_ ? i : i + gap_len_];
+	}
+	const T &operator[](std::size_t i) const
+	{
+		return buf_[i < gap_strt_ ? i : i + gap_len_];
+	}
+	T &at(std::size_t i)
+	{
+		if (i >= size())
+			throw std::out_of_range("srxk::gapbuffer::at");
+		return (*this)[i];
+	}
+	const T &at(std::size_t i) const
+	{
+		return const_cast<gapbuffer*>(this)->at(i);
+	}
+
+	std::size_t size() const { return len_ - gap_len_; }
+	std::size_t cursor() const { return gap_strt_; }
+
+private:
+	std::size_t gap_end() const { return gap_strt_ + gap_len_; }
+
+	void grow(std::size_t amount)
+	{
+		std::size_t after = len_ - gap_end();
+		if constexpr (std::is_trivially_copyable_v<T>) {
+			buf_ = detail::reallocate(buf_, len_, len_ + amount);
+			detail::relocate(buf_ + gap_end() + amount, buf_ + gap_end(), after);
+		} else {
+			T *buf = detail::allocate<T>(len_ + amount);
+			detail::relocate(buf, buf_, gap_strt_);
+			detail::relocate(buf + gap_end() + amount, buf_ + gap_end(), after);
+			std::free(buf_);
+			buf_ = buf;
+		}
+		len_ += amount;
+		gap_len_ += amount;
+	}
+
+	T *buf_ = nullptr;
+	std::size_t len_ = 0;
+	std::size_t gap_strt_ = 0;
+	std::size_t gap_len_ = 0;
+};
+
+} // namespace srxk
+
+#endif // SRXK_HPP
@@ -0,0 +1,358 @@
+/*
+* >> srxk_alloc.h 0.2.0
+* Allocation tracking shared by the srxk headers
+* Every other header includes this, you only need to include it yourself to
+* call `srxk_alloc_report()`
+*
+* >> Usage
+* ```
+* #define SRXK_TRACK_ALLOC
+* //      ^ define this before including any srxk header
+* #include <srxk_vector.h>
+* ...
+* srxk_alloc_report(stderr);
+* ```
+* Without `SRXK_TRACK_ALLOC` the SRXK_* allocation macros are plain malloc,
+* calloc, realloc and free, so nothing is added to the containers or calls.
+*
+* With it every block gets a small header holding its size. Bytes are counted
+* per kind of allocation in `srxk_alloc_totals`, and per container in its
+* `mem` field, which `<prefix>_memory_usage()` reads. The counts are live and
+* peak bytes, and bytes copied by a realloc that moved the block. Like the
+* error numbers the totals are per translation unit. Memory mapped files
+* aren't counted, their pages belong to the page cache
+*
+* The aligned allocation functions back VECTOR_ALIGN and GAPBUFFER_ALIGN,
+* `SRXK_RESTRICT` and `SRXK_ASSUME_ALIGNED` are there for kernels working on
+* the data
+*
+* Custom memory allocators are also supported via by defining CUSTOM_MALLOC,
+* _REALLOC, *_FREE
+*
+* >> License
+* Be Nice Please Public License
+* Version 2, FEBUARY 2020
+*
+* Copyright (C) 2020 Milo Wheeler <milowheeler@protonmail.com>
+*
+* Permission is granted, free of charge, to any person obtaining a copy of this
+* "Software", to the rights to, use, copy, modify, merge, publish, distribute,
+* and/or sell copies of the Software without restriction, this holds true as
+* long as the software is not used to intentionally hurt people, and/or
+* communities emotionally or physically.
+*
+* Due to the nature of Open Source, no liability or warranty of any kind is
+* provided with this Software.
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*/
+
+// This isn't a generic header, so it only needs to be included once
+#ifndef SRXK_ALLOC_H
+#define SRXK_ALLOC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+// INCLUDES
+#include <stdint.h> // uintptr_t
+#include <stdlib.h> // malloc, calloc, realloc, free
+#include <string.h> // memset, memmove
+#ifdef SRXK_TRACK_ALLOC
+	#include <stdio.h> // fprintf
+#endif // SRXK_TRACK_ALLOC
+
+// CONSTANTS
+/*What an allocation is for, each kind is counted separately*/
+#define SRXK_ALLOC_VECTOR 0
+#define SRXK_ALLOC_HT 1 // Tables, bucket arrays and reference bits
+#define SRXK_ALLOC_HT_ITEM 2
+#define SRXK_ALLOC_HT_KEY 3
+#define SRXK_ALLOC_GAPBUFFER 4
+#define SRXK_ALLOC_GB_HISTORY 5
+#define SRXK_ALLOC_DEQUE 6
+#define SRXK_ALLOC_BLOOM 7
+#define SRXK_ALLOC_KINDS 8
+
+// CUSTOM MEMORY MANAGER
+#ifdef CUSTOM_MALLOC
+	// Make sure that realloc and free are also defined
+	#if !defined(CUSTOM_REALLOC) | !defined(CUSTOM_FREE)
+		#error "If a custom malloc is used a custom realloc and free must also\
+				be defined"
+	#endif
+	#define malloc CUSTOM_MALLOC
+	#define realloc CUSTOM_REALLOC
+	#define free CUSTOM_FREE
+#endif
+
+#ifndef SRXK_TRACK_ALLOC
+// ALLOCATION MACROS
+/*kind and inst are thrown away, so inst can name fields that only exist
+when tracking is on*/
+#define SRXK_MALLOC(kind, inst, size) malloc(size)
+#define SRXK_CALLOC(kind, inst, n, size) calloc(n, size)
+#define SRXK_REALLOC(kind, inst, p, size) realloc(p, size)
+#define SRXK_FREE(kind, inst, p) free(p)
+#define SRXK_ALLOC_OWN(inst, p) ((void)0)
+#define SRXK_ALLOC_INST(inst) NULL
+typedef struct srxk_alloc_stats srxk_alloc_stats;
+
+#else
+// STATS TYPE
+typedef struct srxk_alloc_stats
+{
+	size_t live; // Bytes asked for that haven't been freed
+	size_t peak; // The most live has ever been
+	size_t copied; // Bytes moved by realloc
+	long allocs;
+	long reallocs;
+	long frees;
+} srxk_alloc_stats;
+
+/*Every block starts with its size, padded so the memory handed out keeps
+the alignment malloc gave us*/
+typedef union srxk_alloc_head
+{
+	size_t size;
+	long double ld;
+	long long ll;
+	void *p;
+} srxk_alloc_head;
+
+// TOTALS
+static srxk_alloc_stats srxk_alloc_totals[SRXK_ALLOC_KINDS];
+static const char *const srxk_alloc_names[SRXK_ALLOC_KINDS] = {
+	"vector", "hashtable", "hashtable_item", "hashtable_key", "gapbuffer",
+	"gapbuffer_history", "deque", "bloom"};
+
+// ALLOCATION MACROS
+#define SRXK_MALLOC(kind, inst, size) srxk_alloc_malloc(kind, inst, size)
+#define SRXK_CALLOC(kind, inst, n, size) srxk_alloc_calloc(kind, inst, n, size)
+#define SRXK_REALLOC(kind, inst, p, size) \
+		srxk_alloc_realloc(kind, inst, p, size)
+#define SRXK_FREE(kind, inst, p) srxk_alloc_free(kind, inst, p)
+#define SRXK_ALLOC_OWN(inst, p) srxk_alloc_own(inst, p)
+#define SRXK_ALLOC_INST(inst) (inst)
+
+// You shouldn't be calling these for any good reason
+static void srxk_alloc_add(srxk_alloc_stats *s, size_t size)
+{
+	s->live += size;
+	if (s->live > s->peak)
+		s->peak = s->live;
+	++s->allocs;
+}
+
+static void srxk_alloc_sub(srxk_alloc_stats *s, size_t size)
+{
+	s->live -= size;
+	++s->frees;
+}
+
+static void srxk_alloc_resize(srxk_alloc_stats *s, size_t old, size_t size,
+		int moved)
+{
+	s->live += size - old;
+	if (s->live > s->peak)
+		s->peak = s->live;
+	if (moved)
+		s->copied += old < size ? old : size;
+	++s->reallocs;
+}
+
+static void *srxk_alloc_malloc(int kind, srxk_alloc_stats *inst, size_t size)
+{
+	srxk_alloc_head *h = (srxk_alloc_head*)malloc(sizeof(srxk_alloc_head)
+			+ size);
+	if (h == NULL)
+		return NULL;
+	h->size = size;
+	srxk_alloc_add(&srxk_alloc_totals[kind], size);
+	if (inst != NULL)
+		srxk_alloc_add(inst, size);
+	return h + 1;
+}
+
+static void *srxk_alloc_calloc(int kind, srxk_alloc_stats *inst, size_t n,
+		size_t size)
+{
+	if (size != 0 && n > ((size_t)-1 - sizeof(srxk_alloc_head)) / size)
+		return NULL;
+	void *p = srxk_alloc_malloc(kind, inst, n * size);
+	if (p != NULL)
+		memset(p, 0, n * size);
+	return p;
+}
+
+static void *srxk_alloc_realloc(int kind, srxk_alloc_stats *inst, void *p,
+		size_t size)
+{
+	if (p == NULL)
+		return srxk_alloc_malloc(kind, inst, size);
+
+	srxk_alloc_head *h = (srxk_alloc_head*)p - 1;
+	size_t old = h->size;
+	srxk_alloc_head *n = (srxk_alloc_head*)realloc(h,
+			sizeof(srxk_alloc_head) + size);
+	if (n == NULL)
+		return NULL;
+	n->size = size;
+	srxk_alloc_resize(&srxk_alloc_totals[kind], old, size, n != h);
+	if (inst != NULL)
+		srxk_alloc_resize(inst, old, size, n != h);
+	return n + 1;
+}
+
+static void srxk_alloc_free(int kind, srxk_alloc_stats *inst, void *p)
+{
+	if (p == NULL)
+		return;
+	srxk_alloc_head *h = (srxk_alloc_head*)p - 1;
+	srxk_alloc_sub(&srxk_alloc_totals[kind], h->size);
+	if (inst != NULL)
+		srxk_alloc_sub(inst, h->size);
+	free(h);
+}
+
+/*A container is allocated before its stats exist, so this zeros them and
+counts the container's own block*/
+static void srxk_alloc_own(srxk_alloc_stats *inst, void *p)
+{
+	memset(inst, 0, sizeof(srxk_alloc_stats));
+	srxk_alloc_add(inst, ((srxk_alloc_head*)p - 1)->size);
+}
+
+// REPORT FUNCTIONS
+/*
+* Description:
+* 	Prints the totals for every kind of allocation, the overhead column is
+*  what the tracking headers of the live blocks take up
+* Parameters:
+* 	FILE *f - where to print the report
+* Return Value:
+* 	None
+*/
+static void srxk_alloc_report(FILE *f)
+{
+	srxk_alloc_stats all;
+	memset(&all, 0, sizeof(all));
+	fprintf(f, "%-18s %12s %12s %12s %10s %10s %10s %10s\n", "kind", "live",
+			"peak", "copied", "allocs", "reallocs", "frees", "overhead");
+	for (int i = 0; i < SRXK_ALLOC_KINDS; ++i)
+	{
+		const srxk_alloc_stats *s = &srxk_alloc_totals[i];
+		if (s->allocs == 0)
+			continue;
+		fprintf(f, "%-18s %12zu %12zu %12zu %10ld %10ld %10ld %10zu\n",
+				srxk_alloc_names[i], s->live, s->peak, s->copied, s->allocs,
+				s->reallocs, s->frees, (size_t)(s->allocs - s->frees)
+				* sizeof(srxk_alloc_head));
+		all.live += s->live;
+		all.peak += s->peak;
+		all.copied += s->copied;
+		all.allocs += s->allocs;
+		all.reallocs += s->reallocs;
+		all.frees += s->frees;
+	}
+	// The peaks of each kind can happen at different times, so this is only
+	// an upper bound
+	fprintf(f, "%-18s %12zu %12zu %12zu %10ld %10ld %10ld %10zu\n", "total",
+			all.live, all.peak, all.copied, all.allocs, all.reallocs,
+			all.frees, (size_t)(all.allocs - all.frees)
+			* sizeof(srxk_alloc_head));
+}
+#endif // SRXK_TRACK_ALLOC
+
+// KERNEL HELPERS
+/*Put SRXK_RESTRICT on a pointer to promise nothing else touches what it
+points to, so loops over it can be vectorised*/
+#ifdef __cplusplus
+	#define SRXK_RESTRICT __restrict
+#else
+	#define SRXK_RESTRICT restrict
+#endif // __cplusplus
+/*Tells the compiler p is aligned to a bytes, a has to be a constant*/
+#if defined(__GNUC__) || defined(__clang__)
+	#define SRXK_ASSUME_ALIGNED(p, a) __builtin_assume_aligned(p, a)
+#else
+	#define SRXK_ASSUME_ALIGNED(p, a) ((void*)(p))
+#endif
+
+// ALIGNED ALLOCATION
+/*These over allocate by align bytes and keep what malloc returned just in
+front of the aligned pointer, so custom allocators and tracking still work.
+align has to be a power of two*/
+#define SRXK_ALIGNED_ALLOC(kind, inst, align, size) \
+		srxk_aligned_alloc(kind, SRXK_ALLOC_INST(inst), align, size)
+#define SRXK_ALIGNED_REALLOC(kind, inst, p, align, size) \
+		srxk_aligned_realloc(kind, SRXK_ALLOC_INST(inst), p, align, size)
+#define SRXK_ALIGNED_FREE(kind, inst, p) \
+		srxk_aligned_free(kind, SRXK_ALLOC_INST(inst), p)
+/*Rounds n up to a multiple of a, a has to be a power of two*/
+#define SRXK_ALIGN_UP(n, a) (((n) + (a) - 1) & ~(size_t)((a) - 1))
+
+// You shouldn't be calling these for any good reason
+static char *srxk_aligned_place(char *raw, size_t align)
+{
+	return (char*)SRXK_ALIGN_UP((uintptr_t)(raw + sizeof(void*)), align);
+}
+
+static void *srxk_aligned_alloc(int kind, srxk_alloc_stats *inst,
+		size_t align, size_t size)
+{
+	(void)kind;
+	(void)inst;
+	char *raw = (char*)SRXK_MALLOC(kind, inst, size + align - 1
+			+ sizeof(void*));
+	if (raw == NULL)
+		return NULL;
+	char *p = srxk_aligned_place(raw, align);
+	memcpy(p - sizeof(void*), &raw, sizeof(void*));
+	return p;
+}
+
+static void *srxk_aligned_realloc(int kind, srxk_alloc_stats *inst, void *p,
+		size_t align, size_t size)
+{
+	(void)kind;
+	(void)inst;
+	if (p == NULL)
+		return srxk_aligned_alloc(kind, inst, align, size);
+
+	char *raw;
+	memcpy(&raw, (char*)p - sizeof(void*), sizeof(void*));
+	size_t off = (size_t)((char*)p - raw);
+	// realloc keeps the bytes but not the alignment, so if the block moved
+	// to an address with a different offset slide the data back into line
+	char *n = (char*)SRXK_REALLOC(kind, inst, raw, size + align - 1
+			+ sizeof(void*));
+	if (n == NULL)
+		return NULL;
+	// The pointer in front of q can land on the old data, so it is only
+	// written once the data has moved
+	char *q = srxk_aligned_place(n, align);
+	if ((size_t)(q - n) != off)
+		memmove(q, n + off, size);
+	memcpy(q - sizeof(void*), &n, sizeof(void*));
+	return q;
+}
+
+static void srxk_aligned_free(int kind, srxk_alloc_stats *inst, void *p)
+{
+	(void)kind;
+	(void)inst;
+	if (p == NULL)
+		return;
+	char *raw;
+	memcpy(&raw, (char*)p - sizeof(void*), sizeof(void*));
+	SRXK_FREE(kind, inst, raw);
+}
+
+#ifdef __cplusplus
+} // extern "C" closing brace
+#endif	// __cplusplus
+
+#endif // SRXK_ALLOC_H
@@ -0,0 +1,412 @@
+/*
+* >> srxk_bloom.h 0.4.0
+* A C header only blocked bloom filter implementation
+* Each key lives in one block of `BLOOM_BLOCK_BITS` bits, 512 by default so
+* adding or testing a key only ever touches one 64 byte cache line
+*
+* >> Usage
+* ```
+* #include <srxk_bloom.h>
+* ```
+* Everything is prefixed with `srxk_bloom_`, as this header is only included
+* once there is no type in the names. `srxk_bloom_test()` never returns 0 for
+* a key that was added, it might return 1 for a key that wasn't. Keys can't be
+* removed, clear and re-add them instead
+*
+* A filter can be sent somewhere else by writing it out with
+* `srxk_bloom_save()` into `srxk_bloom_size()` bytes and loading it back in
+* with `srxk_bloom_load()`. The format has a header with the parameters it was
+* built with and stores words little endian, so a build with different
+* parameters or on another architecture refuses it rather then giving wrong
+* answers
+*
+* Custom memory allocators are also supported via by defining CUSTOM_MALLOC,
+* _REALLOC, *_FREE
+* If an error ocurrs an integer called `srxk_bloom_err` will be set
+* Define SRXK_TRACK_ALLOC to count the memory filters use, see srxk_alloc.h
+*
+* >> License
+* Be Nice Please Public License
+* Version 2, FEBUARY 2020
+*
+* Copyright (C) 2020 Milo Wheeler <milowheeler@protonmail.com>
+*
+* Permission is granted, free of charge, to any person obtaining a copy of this
+* "Software", to the rights to, use, copy, modify, merge, publish, distribute,
+* and/or sell copies of the Software without restriction, this holds true as
+* long as the software is not used to intentionally hurt people, and/or
+* communities emotionally or physically.
+*
+* Due to the nature of Open Source, no liability or warranty of any kind is
+* provided with this Software.
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*/
+
+// This isn't a generic header, so it only needs to be included once
+#ifndef SRXK_BLOOM_H
+#define SRXK_BLOOM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+// INCLUDES
+#include <stdint.h> // uint64_t, uint32_t
+#include <stdlib.h> // malloc, free
+#include <string.h> // memset, memcpy
+
+// CONSTANTS
+/*These can be tweaked for your needs*/
+#ifndef BLOOM_BITS_PER_KEY
+	#define BLOOM_BITS_PER_KEY 10
+#endif // BLOOM_BITS_PER_KEY
+/*How many bits are set for each key*/
+#ifndef BLOOM_HASHES
+	#define BLOOM_HASHES 7
+#endif // BLOOM_HASHES
+#if BLOOM_HASHES < 1 || BLOOM_HASHES > 255
+	#error "BLOOM_HASHES has to fit in the one byte it is saved in"
+#endif
+/*How big each block is, a power of two from 64 to 32768. Bigger blocks give
+fewer false positives for the same bits per key but span more cache lines*/
+#ifndef BLOOM_BLOCK_BITS
+	#define BLOOM_BLOCK_BITS 512
+#endif // BLOOM_BLOCK_BITS
+#if BLOOM_BLOCK_BITS < 64 || BLOOM_BLOCK_BITS > 32768 \
+		|| (BLOOM_BLOCK_BITS & (BLOOM_BLOCK_BITS - 1))
+	#error "BLOOM_BLOCK_BITS must be a power of two from 64 to 32768"
+#endif
+#define BLOOM_BLOCK_WORDS (BLOOM_BLOCK_BITS / 64)
+#define BLOOM_BLOCK_MASK (BLOOM_BLOCK_BITS - 1)
+/*Blocks start on a cache line, or on their own size if they are smaller so
+one never straddles two lines*/
+#define BLOOM_BLOCK_ALIGN (BLOOM_BLOCK_BITS / 8 < 64 ? BLOOM_BLOCK_BITS / 8 : 64)
+/*The saved format, bump the version if the hash or the layout changes. The
+header is the magic, version, BLOOM_HASHES, BLOOM_BLOCK_BITS as 2 bytes, the
+block count as 4 bytes and 4 zero bytes, all little endian*/
+#define BLOOM_MAGIC "SXBF"
+#define BLOOM_VERSION 1
+#define BLOOM_HEADER_SIZE 16
+
+// CUSTOM MEMORY MANAGER
+#ifdef CUSTOM_MALLOC
+	// Make sure that realloc and free are also defined
+	#if !defined(CUSTOM_REALLOC) | !defined(CUSTOM_FREE)
+		#error "If a custom malloc is used a custom realloc and free must also\
+				be defined"
+	#endif
+	#define malloc CUSTOM_MALLOC
+	#define realloc CUSTOM_REALLOC
+	#define free CUSTOM_FREE
+#endif
+#include "srxk_alloc.h"
+
+// ERROR CODES
+#ifndef ENOMEM
+	#define ENOMEM 12
+#endif
+#ifndef EINVAL
+	#define EINVAL 22
+#endif
+
+// BLOOM TYPE
+typedef struct srxk_bloom
+{
+	uint64_t *blocks; // BLOOM_BLOCK_ALIGN aligned, BLOOM_BLOCK_WORDS words each
+	void *raw; // What was actually allocated
+	uint32_t nblocks;
+#ifdef SRXK_TRACK_ALLOC
+	srxk_alloc_stats mem;
+#endif // SRXK_TRACK_ALLOC
+} srxk_bloom;
+
+// ERROR NUMBER
+static int srxk_bloom_err = 0;
+
+// HASH FUNCTIONS
+/*
+* Description:
+* 	Hashes a key, use this with the *_hash functions to only hash once
+* Parameters:
+* 	const char *k - the null terminated key to hash
+* Return Value:
+* 	The 64 bit hash of the key
+*/
+static uint64_t srxk_bloom_hash(const char *k)
+{
+	// FNV-1a, then mixed so that every bit depends on every byte
+	uint64_t h = 0xcbf29ce484222325ULL;
+	for (; *k != '\0'; ++k)
+		h = (h ^ (unsigned char)*k) * 0x100000001b3ULL;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+// You shouldn't be calling these for any good reason
+static uint64_t *srxk_bloom_block(const srxk_bloom *b, uint64_t h)
+{
+	// Maps the top half of the hash onto [0, nblocks) without a divide
+	uint64_t i = ((h >> 32) * b->nblocks) >> 32;
+	return b->blocks + i * BLOOM_BLOCK_WORDS;
+}
+
+static srxk_bloom *srxk_bloom_alloc(uint32_t nblocks)
+{
+	srxk_bloom *b = (srxk_bloom*)SRXK_MALLOC(SRXK_ALLOC_BLOOM, NULL,
+			sizeof(srxk_bloom));
+	if (b == NULL) {
+		srxk_bloom_err = ENOMEM;
+		return NULL;}
+	SRXK_ALLOC_OWN(&b->mem, b);
+
+	// Over allocate so the blocks can start on a cache line
+	b->nblocks = nblocks;
+	b->raw = SRXK_MALLOC(SRXK_ALLOC_BLOOM, &b->mem, (size_t)nblocks
+			* BLOOM_BLOCK_WORDS * sizeof(uint64_t) + BLOOM_BLOCK_ALIGN);
+	if (b->raw == NULL) {
+		srxk_bloom_err = ENOMEM;
+		SRXK_FREE(SRXK_ALLOC_BLOOM, NULL, b);
+		return NULL;}
+	b->blocks = (uint64_t*)(((uintptr_t)b->raw + BLOOM_BLOCK_ALIGN - 1)
+			& ~(uintptr_t)(BLOOM_BLOCK_ALIGN - 1));
+	return b;
+}
+
+// Words are written a byte at a time so the format doesn't depend on the
+// machine's byte order
+static void srxk_bloom_put(unsigned char *p, uint64_t x, int bytes)
+{
+	for (int i = 0; i < bytes; ++i)
+		p[i] = (unsigned char)(x >> (8 * i));
+}
+
+static uint64_t srxk_bloom_get(const unsigned char *p, int bytes)
+{
+	uint64_t x = 0;
+	for (int i = 0; i < bytes; ++i)
+		x |= (uint64_t)p[i] << (8 * i);
+	return x;
+}
+
+static size_t srxk_bloom_bytes(const srxk_bloom *b)
+{
+	return (size_t)b->nblocks * BLOOM_BLOCK_WORDS * sizeof(uint64_t);
+}
+
+// BLOOM FUNCTIONS
+/*
+* Description:
+* 	Creates a new empty bloom filter
+* Parameters:
+* 	int keys - how many keys the filter is sized for
+* Return Value:
+* 	Returns the newly heap allocated filter
+*/
+static srxk_bloom *srxk_bloom_new(int keys)
+{
+	size_t bits = (size_t)(keys > 0 ? keys : 1) * BLOOM_BITS_PER_KEY;
+	srxk_bloom *b = srxk_bloom_alloc((uint32_t)((bits + BLOOM_BLOCK_BITS - 1)
+			/ BLOOM_BLOCK_BITS));
+	if (b == NULL)
+		return NULL;
+	memset(b->blocks, 0, (size_t)b->nblocks * BLOOM_BLOCK_WORDS
+			* sizeof(uint64_t));
+	return b;
+}
+
+/*
+* Description:
+* 	Gets how many bytes srxk_bloom_save() writes for the filter
+* Parameters:
+* 	const srxk_bloom *b - the filter
+* Return Value:
+* 	The size of the header and the blocks in bytes
+*/
+static size_t srxk_bloom_size(const srxk_bloom *b)
+{
+	return BLOOM_HEADER_SIZE + srxk_bloom_bytes(b);
+}
+
+/*
+* Description:
+* 	Writes the filter out so it can be loaded somewhere else
+* Parameters:
+* 	const srxk_bloom *b - the filter
+* 	void *out - where to write it, srxk_bloom_size() bytes long
+* Return Value:
+* 	How many bytes were written
+*/
+static size_t srxk_bloom_save(const srxk_bloom *b, void *out)
+{
+	unsigned char *p = (unsigned char*)out;
+	memcpy(p, BLOOM_MAGIC, 4);
+	p[4] = BLOOM_VERSION;
+	p[5] = BLOOM_HASHES;
+	srxk_bloom_put(p + 6, BLOOM_BLOCK_BITS, 2);
+	srxk_bloom_put(p + 8, b->nblocks, 4);
+	srxk_bloom_put(p + 12, 0, 4);
+
+	p += BLOOM_HEADER_SIZE;
+	const size_t words = (size_t)b->nblocks * BLOOM_BLOCK_WORDS;
+	for (size_t i = 0; i < words; ++i, p += 8)
+		srxk_bloom_put(p, b->blocks[i], 8);
+	return srxk_bloom_size(b);
+}
+
+/*
+* Description:
+* 	Creates a bloom filter from one written out by srxk_bloom_save()
+* Parameters:
+* 	const void *data - the saved filter
+* 	size_t size - how many bytes are in data
+* Return Value:
+* 	Returns the newly heap allocated filter, or NULL and sets srxk_bloom_err
+* 	to EINVAL if data isn't a saved filter, was saved by another version or
+* 	with a different BLOOM_HASHES or BLOOM_BLOCK_BITS, or size doesn't match
+*/
+static srxk_bloom *srxk_bloom_load(const void *data, size_t size)
+{
+	const unsigned char *p = (const unsigned char*)data;
+	const size_t block = BLOOM_BLOCK_WORDS * sizeof(uint64_t);
+	if (size < BLOOM_HEADER_SIZE || memcmp(p, BLOOM_MAGIC, 4) != 0
+			|| p[4] != BLOOM_VERSION || p[5] != BLOOM_HASHES
+			|| srxk_bloom_get(p + 6, 2) != BLOOM_BLOCK_BITS
+			|| srxk_bloom_get(p + 12, 4) != 0) {
+		srxk_bloom_err = EINVAL;
+		return NULL;}
+	uint64_t nblocks = srxk_bloom_get(p + 8, 4);
+	if (nblocks == 0 || (size - BLOOM_HEADER_SIZE) / block != nblocks
+			|| (size - BLOOM_HEADER_SIZE) % block != 0) {
+		srxk_bloom_err = EINVAL;
+		return NULL;}
+
+	srxk_bloom *b = srxk_bloom_alloc((uint32_t)nblocks);
+	if (b == NULL)
+		return NULL;
+	p += BLOOM_HEADER_SIZE;
+	const size_t words = (size_t)nblocks * BLOOM_BLOCK_WORDS;
+	for (size_t i = 0; i < words; ++i, p += 8)
+		b->blocks[i] = srxk_bloom_get(p, 8);
+	return b;
+}
+
+/*
+* Description:
+* 	Adds a key that has already been hashed with srxk_bloom_hash()
+* Parameters:
+* 	srxk_bloom *b - the filter to be operated on
+* 	uint64_t h - the hash of the key
+* Return Value:
+* 	None
+*/
+static void srxk_bloom_add_hash(srxk_bloom *b, uint64_t h)
+{
+	uint64_t *block = srxk_bloom_block(b, h);
+	// Double hashing inside the block with the bottom half of the hash
+	uint32_t x = (uint32_t)h;
+	uint32_t step = (x >> 16) | 1;
+	for (int i = 0; i < BLOOM_HASHES; ++i, x += step)
+		block[(x & BLOOM_BLOCK_MASK) >> 6] |= 1ULL << (x & 63);
+}
+
+/*
+* Description:
+* 	Tests a key that has already been hashed with srxk_bloom_hash()
+* Parameters:
+* 	const srxk_bloom *b - the filter to be operated on
+* 	uint64_t h - the hash of the key
+* Return Value:
+* 	0 if the key was definitely never added, otherwise 1
+*/
+static int srxk_bloom_test_hash(const srxk_bloom *b, uint64_t h)
+{
+	const uint64_t *block = srxk_bloom_block(b, h);
+	uint32_t x = (uint32_t)h;
+	uint32_t step = (x >> 16) | 1;
+	for (int i = 0; i < BLOOM_HASHES; ++i, x += step)
+		if (!(block[(x & BLOOM_BLOCK_MASK) >> 6] & (1ULL << (x & 63))))
+			return 0;
+	return 1;
+}
+
+/*
+* Description:
+* 	Adds a key to the filter
+* Parameters:
+* 	srxk_bloom *b - the filter to be operated on
+* 	const char *k - the key to add
+* Return Value:
+* 	None
+*/
+static void srxk_bloom_add(srxk_bloom *b, const char *k)
+{
+	srxk_bloom_add_hash(b, srxk_bloom_hash(k));
+}
+
+/*
+* Description:
+* 	Tests if a key might have been added to the filter
+* Parameters:
+* 	const srxk_bloom *b - the filter to be operated on
+* 	const char *k - the key to test
+* Return Value:
+* 	0 if the key was definitely never added, otherwise 1
+*/
+static int srxk_bloom_test(const srxk_bloom *b, const char *k)
+{
+	return srxk_bloom_test_hash(b, srxk_bloom_hash(k));
+}
+
+/*
+* Description:
+* 	Removes every key from the filter
+* Parameters:
+* 	srxk_bloom *b - the filter to be operated on
+* Return Value:
+* 	None
+*/
+static void srxk_bloom_clear(srxk_bloom *b)
+{
+	memset(b->blocks, 0, srxk_bloom_bytes(b));
+}
+
+/*
+* Description:
+* 	Frees a filter
+* Parameters:
+* 	srxk_bloom *b - the filter to be operated on
+* Return Value:
+* 	None
+*/
+static void srxk_bloom_free(srxk_bloom *b)
+{
+	SRXK_FREE(SRXK_ALLOC_BLOOM, &b->mem, b->raw);
+	SRXK_FREE(SRXK_ALLOC_BLOOM, NULL, b);
+}
+
+#ifdef SRXK_TRACK_ALLOC
+/*
+* Description:
+* 	Gets how many bytes the filter has allocated, its self included
+* Parameters:
+* 	const srxk_bloom *b - the filter
+* Return Value:
+* 	The live bytes, b->mem has the rest of the counts
+*/
+static size_t srxk_bloom_memory_usage(const srxk_bloom *b)
+{
+	return b->mem.live;
+}
+#endif // SRXK_TRACK_ALLOC
+
+#ifdef __cplusplus
+} // extern "C" closing brace
+#endif	// __cplusplus
+
+#endif // SRXK_BLOOM_H
@@ -0,0 +1,376 @@
+/*
+* >> srxk_deque.h 0.1.1
+* A generic C header only double ended queue implementation
+* Elements are stored in fixed size chunks that never move, so a pointer to
+* an element stays valid until that element is popped
+*
+* >> Usage
+* ```
+* #define DEQUE_TYPE int
+* //                 ^ you can put any valid c type here
+* #include <srxk_deque.h>
+* ```
+* If you want to use a pointer or struct you must first typedef it like so:
+* `typedef struct object* objectp;`
+*
+* Custom memory allocators are also supported via by defining CUSTOM_MALLOC,
+* _REALLOC, *_FREE
+* If an error ocurrs an integer called `deque_<type>_err` will be set
+* Define SRXK_TRACK_ALLOC to count the memory deques use, see srxk_alloc.h
+*
+* There some examples in `test/` if you need a guide
+*
+* >> License
+* Be Nice Please Public License
+* Version 2, FEBUARY 2020
+*
+* Copyright (C) 2020 Milo Wheeler <milowheeler@protonmail.com>
+*
+* Permission is granted, free of charge, to any person obtaining a copy of this
+* "Software", to the rights to, use, copy, modify, merge, publish, distribute,
+* and/or sell copies of the Software without restriction, this holds true as
+* long as the software is not used to intentionally hurt people, and/or
+* communities emotionally or physically.
+*
+* Due to the nature of Open Source, no liability or warranty of any kind is
+* provided with this Software.
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+// INCLUDES
+#include <stdlib.h> // malloc, calloc, free
+#include <string.h> // memcpy
+
+// CONSTANTS
+/*These can be tweaked for your needs*/
+/*Each chunk holds 1 << DEQUE_CHUNK_SHIFT elements*/
+#ifndef DEQUE_CHUNK_SHIFT
+	#define DEQUE_CHUNK_SHIFT 8
+#endif // DEQUE_CHUNK_SHIFT
+/*How many empty chunks are kept around for reuse*/
+#ifndef DEQUE_FREE_MAX
+	#define DEQUE_FREE_MAX 4
+#endif // DEQUE_FREE_MAX
+#define DEQUE_CHUNK_LEN (1 << DEQUE_CHUNK_SHIFT)
+#define DEQUE_CHUNK_MASK (DEQUE_CHUNK_LEN - 1)
+#if DEQUE_CHUNK_SHIFT < 3
+	#error "DEQUE_CHUNK_SHIFT must be at least 3, free chunks are linked\
+			through their first element"
+#endif
+
+// THE MACRO MAGIC
+#ifndef DEQUE_TYPE
+	#define DEQUE_TYPE int
+#endif
+
+#define PASTER(x,y) x ## _ ## y
+#define EVALUATOR(x,y)  PASTER(x,y)
+
+#define type(struct,type) EVALUATOR(struct, type)
+#define function(name) EVALUATOR(DEQUE, name)
+
+#define DEQUE type(deque, DEQUE_TYPE)
+#define DEQUE_ERR EVALUATOR(DEQUE, err)
+
+// CUSTOM MEMORY MANAGER
+#ifdef CUSTOM_MALLOC
+	// Make sure that realloc and free are also defined
+	#if !defined(CUSTOM_REALLOC) | !defined(CUSTOM_FREE)
+		#error "If a custom malloc is used a custom realloc and free must also\
+				be defined"
+	#endif
+	#define malloc CUSTOM_MALLOC
+	#define realloc CUSTOM_REALLOC
+	#define free CUSTOM_FREE
+#endif
+#include "srxk_alloc.h"
+
+// ERROR CODES
+#ifndef ENOMEM
+	#define ENOMEM 12
+#endif
+#ifndef ENODATA
+	#define ENODATA 61
+#endif
+
+// DEQUE TYPE
+typedef struct DEQUE
+{
+	DEQUE_TYPE **map; // Chunk pointers, NULL if the chunk isn't in use
+	int map_len;
+	int head; // Index of the first element counting from the first chunk
+	int len;
+	DEQUE_TYPE *spare; // Free chunks, linked through their first element
+	int nspare;
+#ifdef SRXK_TRACK_ALLOC
+	srxk_alloc_stats mem;
+#endif // SRXK_TRACK_ALLOC
+} DEQUE;
+
+// ERROR NUMBER
+static int DEQUE_ERR = 0;
+
+// CHUNK FUNCTIONS
+// You shouldn't be calling these for any good reason
+static DEQUE_TYPE *function(chunk_get)(DEQUE *d)
+{
+	// Reuse a free chunk if we have one
+	if (d->spare != NULL)
+	{
+		DEQUE_TYPE *c = d->spare;
+		memcpy(&d->spare, c, sizeof(DEQUE_TYPE*));
+		--d->nspare;
+		return c;
+	}
+	return (DEQUE_TYPE*)SRXK_MALLOC(SRXK_ALLOC_DEQUE, &d->mem,
+			sizeof(DEQUE_TYPE) * DEQUE_CHUNK_LEN);
+}
+
+static void function(chunk_put)(DEQUE *d, int i)
+{
+	DEQUE_TYPE *c = d->map[i];
+	d->map[i] = NULL;
+	if (d->nspare == DEQUE_FREE_MAX) {
+		SRXK_FREE(SRXK_ALLOC_DEQUE, &d->mem, c);
+		return; }
+	memcpy(c, &d->spare, sizeof(DEQUE_TYPE*));
+	d->spare = c;
+	++d->nspare;
+}
+
+static int function(remap)(DEQUE *d)
+{
+	// Only the chunk pointers in use move, the chunks themselves stay put
+	int first = d->head >> DEQUE_CHUNK_SHIFT;
+	int last = (d->head + d->len) >> DEQUE_CHUNK_SHIFT;
+	int used = last - first + 1;
+	// The chunk after the back might not be in the map yet
+	int copy = (last < d->map_len ? last : d->map_len - 1) - first + 1;
+	int map_len = used * 2 < d->map_len ? d->map_len : d->map_len * 2;
+	if (map_len < 8)
+		map_len = 8;
+
+	DEQUE_TYPE **map = (DEQUE_TYPE**)SRXK_CALLOC(SRXK_ALLOC_DEQUE, &d->mem,
+			(size_t)map_len, sizeof(DEQUE_TYPE*));
+	if (map == NULL) {
+		DEQUE_ERR = ENOMEM;
+		return -1; }
+
+	// Leave the same amount of room at both ends
+	int new_first = (map_len - used) / 2;
+	if (d->map != NULL)
+		memcpy(map + new_first, d->map + first, sizeof(DEQUE_TYPE*) * copy);
+	SRXK_FREE(SRXK_ALLOC_DEQUE, &d->mem, d->map);
+	d->map = map;
+	d->map_len = map_len;
+	d->head += (new_first - first) * DEQUE_CHUNK_LEN;
+	return 0;
+}
+
+// DEQUE FUNCTIONS
+/*
+* Description:
+* 	Creates a new empty deque
+* Parameters:
+* 	None
+* Return Value:
+* 	Return the newly heap allocated deque object
+*/
+static DEQUE *function(new)()
+{
+	DEQUE *d = (DEQUE*)SRXK_MALLOC(SRXK_ALLOC_DEQUE, NULL, sizeof(DEQUE));
+	if (d == NULL) {
+		DEQUE_ERR = ENOMEM;
+		return NULL;}
+	SRXK_ALLOC_OWN(&d->mem, d);
+
+	d->map = NULL;
+	d->map_len = 0;
+	d->head = 0;
+	d->len = 0;
+	d->spare = NULL;
+	d->nspare = 0;
+	if (function(remap)(d) < 0) {
+		SRXK_FREE(SRXK_ALLOC_DEQUE, NULL, d);
+		return NULL;}
+	return d;
+}
+
+/*
+* Description:
+* 	Gets a pointer to the element at an index, it stays valid until the
+*  element is popped
+* Parameters:
+* 	DEQUE *d - the deque to be operated on
+* 	int i - the index, 0 being the front
+* Return Value:
+* 	A pointer to the element, or NULL and sets DEQUE_ERR to ENODATA if i is
+*  out of bounds
+*/
+static DEQUE_TYPE *function(at)(const DEQUE *d, int i)
+{
+	if (i < 0 || i >= d->len) {
+		DEQUE_ERR = ENODATA;
+		return NULL;}
+	int g = d->head + i;
+	return &d->map[g >> DEQUE_CHUNK_SHIFT][g & DEQUE_CHUNK_MASK];
+}
+
+/*
+* Description:
+* 	Adds a new item to the back of the deque
+* Parameters:
+* 	DEQUE *d - the deque to be operated on
+* 	DEQUE_TYPE data - the data to be pushed
+* Return Value:
+* 	The deque operated on, or NULL and sets DEQUE_ERR to ENOMEM
+*/
+static DEQUE *function(push_back)(DEQUE *d, DEQUE_TYPE data)
+{
+	int g = d->head + d->len;
+	if ((g >> DEQUE_CHUNK_SHIFT) >= d->map_len)
+	{
+		if (function(remap)(d) < 0)
+			return NULL;
+		g = d->head + d->len;
+	}
+
+	DEQUE_TYPE **c = &d->map[g >> DEQUE_CHUNK_SHIFT];
+	if (*c == NULL && (*c = function(chunk_get)(d)) == NULL) {
+		DEQUE_ERR = ENOMEM;
+		return NULL;}
+	(*c)[g & DEQUE_CHUNK_MASK] = data;
+	++d->len;
+	return d;
+}
+
+/*
+* Description:
+* 	Adds a new item to the front of the deque
+* Parameters:
+* 	DEQUE *d - the deque to be operated on
+* 	DEQUE_TYPE data - the data to be pushed
+* Return Value:
+* 	The deque operated on, or NULL and sets DEQUE_ERR to ENOMEM
+*/
+static DEQUE *function(push_front)(DEQUE *d, DEQUE_TYPE data)
+{
+	if (d->head == 0 && function(remap)(d) < 0)
+		return NULL;
+
+	int g = d->head - 1;
+	DEQUE_TYPE **c = &d->map[g >> DEQUE_CHUNK_SHIFT];
+	if (*c == NULL && (*c = function(chunk_get)(d)) == NULL) {
+		DEQUE_ERR = ENOMEM;
+		return NULL;}
+	(*c)[g & DEQUE_CHUNK_MASK] = data;
+	d->head = g;
+	++d->len;
+	return d;
+}
+
+/*
+* Description:
+* 	Pops the item at the back of the deque
+* Parameters:
+* 	DEQUE *d - the deque to be operated on
+* Return Value:
+* 	The popped value, or a zero'd value and sets DEQUE_ERR to ENODATA if
+*  the deque is empty
+*/
+static DEQUE_TYPE function(pop_back)(DEQUE *d)
+{
+	DEQUE_TYPE data = {0};
+	if (d->len == 0) {
+		DEQUE_ERR = ENODATA;
+		return data;}
+
+	int g = d->head + --d->len;
+	data = d->map[g >> DEQUE_CHUNK_SHIFT][g & DEQUE_CHUNK_MASK];
+	// Give the chunk back once it is empty
+	if ((g & DEQUE_CHUNK_MASK) == 0)
+		function(chunk_put)(d, g >> DEQUE_CHUNK_SHIFT);
+	return data;
+}
+
+/*
+* Description:
+* 	Pops the item at the front of the deque
+* Parameters:
+* 	DEQUE *d - the deque to be operated on
+* Return Value:
+* 	The popped value, or a zero'd value and sets DEQUE_ERR to ENODATA if
+*  the deque is empty
+*/
+static DEQUE_TYPE function(pop_front)(DEQUE *d)
+{
+	DEQUE_TYPE data = {0};
+	if (d->len == 0) {
+		DEQUE_ERR = ENODATA;
+		return data;}
+
+	int g = d->head++;
+	--d->len;
+	data = d->map[g >> DEQUE_CHUNK_SHIFT][g & DEQUE_CHUNK_MASK];
+	// Give the chunk back once it is empty
+	if ((d->head & DEQUE_CHUNK_MASK) == 0)
+		function(chunk_put)(d, g >> DEQUE_CHUNK_SHIFT);
+	return data;
+}
+
+/*
+* Description:
+* 	Frees a deque, its chunks and its self
+* Parameters:
+* 	DEQUE *d - the deque to be operated on
+* Return Value:
+* 	None
+*/
+static void function(free)(DEQUE *d)
+{
+	for (int i = 0; i < d->map_len; ++i)
+		SRXK_FREE(SRXK_ALLOC_DEQUE, &d->mem, d->map[i]);
+	while (d->spare != NULL)
+	{
+		DEQUE_TYPE *c = d->spare;
+		memcpy(&d->spare, c, sizeof(DEQUE_TYPE*));
+		SRXK_FREE(SRXK_ALLOC_DEQUE, &d->mem, c);
+	}
+	SRXK_FREE(SRXK_ALLOC_DEQUE, &d->mem, d->map);
+	SRXK_FREE(SRXK_ALLOC_DEQUE, NULL, d);
+}
+
+#ifdef SRXK_TRACK_ALLOC
+/*
+* Description:
+* 	Gets how many bytes the deque has allocated, spare chunks and its self
+*  included
+* Parameters:
+* 	const DEQUE *d - the deque to be operated on
+* Return Value:
+* 	The live bytes, d->mem has the rest of the counts
+*/
+static size_t function(memory_usage)(const DEQUE *d)
+{
+	return d->mem.live;
+}
+#endif // SRXK_TRACK_ALLOC
+
+// Undefine the macros to keep things clean
+#undef DEQUE
+#undef DEQUE_TYPE
+#undef DEQUE_ERR
+#undef PASTER
+#undef EVALUATOR
+#undef function
+#undef type
+
+#ifdef __cplusplus
+} // extern "C" closing brace
+#endif	// __cplusplus
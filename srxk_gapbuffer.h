@@ -1,5 +1,5 @@
 /*
-* >> srxk_gapbuffer.h 0.1.0
+* >> srxk_gapbuffer.h 0.5.0
 * A generic C header only gap buffer implementation
 *
 * >> Usage
@@ -14,6 +14,27 @@
 * Custom memory allocators are also supported via by defining CUSTOM_MALLOC,
 * _REALLOC, *_FREE
 * If an error ocurrs an integer called `gb_<type>_err` will be set
+* Define SRXK_TRACK_ALLOC to count the memory gap buffers use, see
+* srxk_alloc.h
+*
+* Defining `GAPBUFFER_ALIGN N` keeps the buffer aligned to N bytes (a power of
+* two) across growth, with its length padded to whole multiples of N bytes.
+* `gb_<type>_data(gb)` hands the buffer to a kernel with the alignment known
+*
+* On POSIX systems a file can be mapped straight into a gap buffer with
+* `gb_<type>_open_file()` and written back with `gb_<type>_save()`, define
+* `GAPBUFFER_NO_FILE` to leave these out. Lengths are ints, so a file can be
+* at most INT_MAX elements rounded down to a page (just under 2 GiB of char),
+* the gap reserved after it is cut short near that limit
+*
+* Undo and redo are turned on per buffer with `gb_<type>_journal(gb, cap)`,
+* edits are then recorded as runs of inserted and deleted elements, using at
+* most cap bytes of memory. A single run bigger then cap can't be undone, it
+* clears the journal instead
+*
+* A batch of edits, like a find and replace, can be applied in one pass over
+* the buffer with `gb_<type>_apply_edits(gb, edits, n)` where each
+* `gb_<type>_edit` deletes del elements at pos and inserts len in their place
 *
 * >> License
 * Be Nice Please Public License
@@ -39,13 +60,34 @@ extern "C" {
 #endif // __cplusplus
 
 // INCLUDES
-#include <stdlib.h> // malloc, realloc, free
+#include <stdlib.h> // malloc, realloc, free, realpath
+#include <string.h> // memcpy, memmove
+#include <limits.h> // INT_MAX
+#ifndef GAPBUFFER_NO_FILE
+	#include <errno.h> // errno
+	#include <fcntl.h> // open
+	#include <stdio.h> // rename
+	#include <sys/mman.h> // mmap, munmap
+	#include <sys/stat.h> // fstat, stat, fchmod
+	#include <unistd.h> // write, pread, fsync, close, unlink, sysconf
+#endif // GAPBUFFER_NO_FILE
 
 // CONSTANTS
 /*These can be tweaked for your needs*/
 #ifndef GAPBUFFER_GROW_SIZE
 	#define GAPBUFFER_GROW_SIZE 10
 #endif // GAPBUFFER_GROW_SIZE
+/*How many elements of address space are reserved after a mapped file, this is
+the gap you get to type into before the file has to be copied to the heap*/
+#ifndef GAPBUFFER_MAP_RESERVE
+	#define GAPBUFFER_MAP_RESERVE 65536
+#endif // GAPBUFFER_MAP_RESERVE
+
+// JOURNAL OPERATIONS
+#ifndef GAPBUFFER_OP_INSERT
+	#define GAPBUFFER_OP_INSERT 1
+	#define GAPBUFFER_OP_DELETE 2
+#endif // GAPBUFFER_OP_INSERT
 
 // THE MACRO MAGIC
 #ifndef GAPBUFFER_TYPE
@@ -60,6 +102,31 @@ extern "C" {
 
 #define GAPBUFFER type(gb, GAPBUFFER_TYPE)
 #define GAPBUFFER_ERR EVALUATOR(GAPBUFFER, err)
+#define GAPBUFFER_HIST EVALUATOR(GAPBUFFER, history)
+#define GAPBUFFER_HREC EVALUATOR(GAPBUFFER_HIST, rec)
+#define GAPBUFFER_EDIT EVALUATOR(GAPBUFFER, edit)
+
+#ifdef GAPBUFFER_ALIGN
+	#if GAPBUFFER_ALIGN < 1 || (GAPBUFFER_ALIGN & (GAPBUFFER_ALIGN - 1))
+		#error "GAPBUFFER_ALIGN must be a power of two"
+	#endif
+	// Rounds a length up so it fills whole multiples of GAPBUFFER_ALIGN bytes
+	#define GAPBUFFER_PAD(n) ((int)(SRXK_ALIGN_UP((size_t)(n) \
+			* sizeof(GAPBUFFER_TYPE), GAPBUFFER_ALIGN) / sizeof(GAPBUFFER_TYPE)))
+	#define GAPBUFFER_ALLOC(inst, size) SRXK_ALIGNED_ALLOC( \
+			SRXK_ALLOC_GAPBUFFER, inst, GAPBUFFER_ALIGN, size)
+	#define GAPBUFFER_REALLOC(inst, p, size) SRXK_ALIGNED_REALLOC( \
+			SRXK_ALLOC_GAPBUFFER, inst, p, GAPBUFFER_ALIGN, size)
+	#define GAPBUFFER_FREE(inst, p) SRXK_ALIGNED_FREE(SRXK_ALLOC_GAPBUFFER, \
+			inst, p)
+#else
+	#define GAPBUFFER_PAD(n) (n)
+	#define GAPBUFFER_ALLOC(inst, size) SRXK_MALLOC(SRXK_ALLOC_GAPBUFFER, \
+			inst, size)
+	#define GAPBUFFER_REALLOC(inst, p, size) SRXK_REALLOC( \
+			SRXK_ALLOC_GAPBUFFER, inst, p, size)
+	#define GAPBUFFER_FREE(inst, p) SRXK_FREE(SRXK_ALLOC_GAPBUFFER, inst, p)
+#endif // GAPBUFFER_ALIGN
 
 // CUSTOM MEMORY MANAGER
 #ifdef CUSTOM_MALLOC
@@ -72,6 +139,7 @@ extern "C" {
 	#define realloc CUSTOM_REALLOC
 	#define free CUSTOM_FREE
 #endif
+#include "srxk_alloc.h"
 
 // ERROR CODES
 #ifndef ENOMEM
@@ -80,6 +148,45 @@ extern "C" {
 #ifndef ENODATA
 	#define ENODATA 61
 #endif
+#ifndef EINVAL
+	#define EINVAL 22
+#endif
+
+// JOURNAL RECORD
+typedef struct GAPBUFFER_HREC
+{
+	int op; // GAPBUFFER_OP_INSERT or GAPBUFFER_OP_DELETE
+	int group; // Records in the same group are undone together
+	int pos; // Where the run starts in the buffer
+	int len; // How many elements are in the run
+	int off; // Where the run is stored in the journal data
+} GAPBUFFER_HREC;
+
+// JOURNAL TYPE
+typedef struct GAPBUFFER_HIST
+{
+	GAPBUFFER_HREC *recs;
+	int count;
+	int applied; // Records after this have been undone and can be redone
+	int recs_cap;
+	GAPBUFFER_TYPE *data; // Deleted runs are stored back to front
+	int data_len;
+	int data_cap;
+	size_t cap; // Most bytes the journal may use
+	int open; // If the last record can still be extended
+	int group;
+	int depth;
+	int replaying;
+} GAPBUFFER_HIST;
+
+// EDIT TYPE
+typedef struct GAPBUFFER_EDIT
+{
+	int pos; // Where the edit starts, in the text from before the batch
+	int del; // How many elements to delete from pos
+	const GAPBUFFER_TYPE *data; // What to insert at pos, only read if len > 0
+	int len;
+} GAPBUFFER_EDIT;
 
 // GAPBUFFER TYPE
 typedef struct GAPBUFFER
@@ -88,6 +195,14 @@ typedef struct GAPBUFFER
 	int len;
 	int gap_strt;
 	int gap_len;
+	void *map; // Set if buf is a file mapping rather then heap memory
+	size_t map_size;
+	int map_fd; // The mapped file, kept open until the gap is first placed
+	int map_clean; // How many elements at the front still match the file
+	GAPBUFFER_HIST *history; // NULL unless the journal is turned on
+#ifdef SRXK_TRACK_ALLOC
+	srxk_alloc_stats mem; // Heap memory only, not the file mapping
+#endif // SRXK_TRACK_ALLOC
 } GAPBUFFER;
 
 // ERROR NUMBER
@@ -105,16 +220,25 @@ static int GAPBUFFER_ERR = 0;
 static GAPBUFFER *function(new)(int size)
 {
 	// Create our gap buffer
-	GAPBUFFER *gb = (GAPBUFFER*)malloc(sizeof(GAPBUFFER));
+	GAPBUFFER *gb = (GAPBUFFER*)SRXK_MALLOC(SRXK_ALLOC_GAPBUFFER, NULL,
+			sizeof(GAPBUFFER));
 	if (gb == NULL) {
 		GAPBUFFER_ERR = ENOMEM;
 		return NULL; }
+	SRXK_ALLOC_OWN(&gb->mem, gb);
 
 	// Create our gap buffer buffer, and set values
-	gb->buf = (GAPBUFFER_TYPE*)malloc(sizeof(GAPBUFFER_TYPE) * size);
+	size = GAPBUFFER_PAD(size);
+	gb->buf = (GAPBUFFER_TYPE*)GAPBUFFER_ALLOC(&gb->mem,
+			sizeof(GAPBUFFER_TYPE) * size);
 	gb->len = size;
 	gb->gap_strt = 0;
 	gb->gap_len = size;
+	gb->map = NULL;
+	gb->map_size = 0;
+	gb->map_fd = -1;
+	gb->map_clean = 0;
+	gb->history = NULL;
 
 	// Check that it didn't fail
 	if (gb->buf == NULL) {
@@ -140,6 +264,8 @@ static void function(left)(GAPBUFFER *gb)
 	 
 	// Move down our gap start
 	--gb->gap_strt;
+	if (gb->gap_strt < gb->map_clean)
+		gb->map_clean = gb->gap_strt;
 	// Copy data to other end of gap
 	gb->buf[gb->gap_strt+gb->gap_len] = gb->buf[gb->gap_strt];
 }
@@ -164,6 +290,81 @@ static void function(right)(GAPBUFFER *gb)
 	++gb->gap_strt;
 }
 
+// MAPPING HELPERS
+// You shouldn't be calling these for any good reason
+static void function(unmap)(GAPBUFFER *gb)
+{
+	#ifndef GAPBUFFER_NO_FILE
+		munmap(gb->map, gb->map_size);
+		if (gb->map_fd >= 0)
+			close(gb->map_fd);
+	#endif // GAPBUFFER_NO_FILE
+	gb->map = NULL;
+	gb->map_size = 0;
+	gb->map_fd = -1;
+	gb->map_clean = 0;
+}
+
+#ifndef GAPBUFFER_NO_FILE
+// Reads len bytes from fd at off, for when the file can't be mapped again
+static int function(read_all)(int fd, char *p, size_t len, off_t off)
+{
+	while (len > 0)
+	{
+		ssize_t n = pread(fd, p, len, off);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0) {
+			errno = n < 0 ? errno : EIO;
+			return -1; }
+		p += n;
+		len -= (size_t)n;
+		off += n;
+	}
+	return 0;
+}
+
+// Places the gap at pos the first time the cursor leaves the end of a mapped
+// file, rather then moving everything after pos up. The text after pos is
+// mapped from the file again a page aligned gap further on, so only the page
+// holding pos ends up in both. Returns 0 if the text isn't the file any more
+static int function(place)(GAPBUFFER *gb, int pos)
+{
+	if (gb->gap_strt != gb->map_clean || gb->gap_strt + gb->gap_len != gb->len)
+		return 0;
+
+	// The gap has to be whole pages and whole elements
+	size_t size = sizeof(GAPBUFFER_TYPE);
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	size_t off = (size_t)pos * size & ~(page - 1);
+	size_t end = ((size_t)gb->gap_strt * size + page - 1) & ~(page - 1);
+	size_t gap = gb->map_size - end;
+	while (gap >= page && gap % size != 0)
+		gap -= page;
+	if (gap < page)
+		return 0;
+
+	// Whatever was mapped there is gap or comes from the file, so if the
+	// mapping fails the text can still be read back into its place
+	char *to = (char*)gb->map + off + gap;
+	if (mmap(to, end - off, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+			gb->map_fd, (off_t)off) == MAP_FAILED)
+	{
+		if (mmap(to, end - off, PROT_READ | PROT_WRITE, MAP_PRIVATE
+				| MAP_ANONYMOUS | MAP_FIXED, -1, 0) == MAP_FAILED
+				|| function(read_all)(gb->map_fd, to,
+				(size_t)gb->gap_strt * size - off, (off_t)off) < 0) {
+			GAPBUFFER_ERR = errno;
+			return 0; }
+	}
+
+	gb->len = gb->gap_strt + (int)(gap / size);
+	gb->gap_strt = pos;
+	gb->gap_len = (int)(gap / size);
+	return 1;
+}
+#endif // GAPBUFFER_NO_FILE
+
 /* 
 * Description:
 * 	Grows the gap buffer by x units
@@ -175,19 +376,237 @@ static void function(right)(GAPBUFFER *gb)
 */
 static void function(grow)(GAPBUFFER *gb, int amount)
 {
-	// Reallocate the buffer
-	GAPBUFFER_TYPE *tmp = (GAPBUFFER_TYPE*)realloc(gb->buf, gb->len
-			+ (amount * sizeof(GAPBUFFER_TYPE)));
-	if (tmp == NULL) { // Check that it didn't fail
+	// len is an int, so we can't go past INT_MAX
+	if ((long long)gb->len + amount > INT_MAX) {
 		GAPBUFFER_ERR = ENOMEM;
 		return; }
 
+	// Everything after the gap has to move up by amount
+	amount = GAPBUFFER_PAD(gb->len + amount) - gb->len;
+	int after = gb->gap_strt + gb->gap_len;
+	int after_len = gb->len - after;
+	GAPBUFFER_TYPE *tmp;
+
+	if (gb->map != NULL)
+	{
+		// A mapping can't be realloc'd, so this is when we copy to the heap
+		tmp = (GAPBUFFER_TYPE*)GAPBUFFER_ALLOC(&gb->mem,
+				sizeof(GAPBUFFER_TYPE) * (gb->len + amount));
+		if (tmp == NULL) { // Check that it didn't fail
+			GAPBUFFER_ERR = ENOMEM;
+			return; }
+		memcpy(tmp, gb->buf, sizeof(GAPBUFFER_TYPE) * gb->gap_strt);
+		memcpy(tmp + after + amount, gb->buf + after,
+				sizeof(GAPBUFFER_TYPE) * after_len);
+		function(unmap)(gb);
+	} else {
+		// Reallocate the buffer
+		tmp = (GAPBUFFER_TYPE*)GAPBUFFER_REALLOC(&gb->mem, gb->buf,
+				sizeof(GAPBUFFER_TYPE) * (gb->len + amount));
+		if (tmp == NULL) { // Check that it didn't fail
+			GAPBUFFER_ERR = ENOMEM;
+			return; }
+		memmove(tmp + after + amount, tmp + after,
+				sizeof(GAPBUFFER_TYPE) * after_len);
+	}
+
 	// Update values
 	gb->buf = tmp;
 	gb->len += amount;
 	gb->gap_len += amount;
 }
 
+// JOURNAL HELPERS
+// You shouldn't be calling these for any good reason
+static size_t function(history_bytes)(const GAPBUFFER_HIST *h)
+{
+	return sizeof(GAPBUFFER_HREC) * (size_t)h->count
+			+ sizeof(GAPBUFFER_TYPE) * (size_t)h->data_len;
+}
+
+static void function(history_fit)(GAPBUFFER *gb)
+{
+	// Give back whatever the arrays grew past the cap, otherwise one big run
+	// keeps its memory long after it has been trimmed
+	GAPBUFFER_HIST *h = gb->history;
+	size_t data_limit = h->cap / sizeof(GAPBUFFER_TYPE);
+	if ((size_t)h->data_cap > data_limit && (size_t)h->data_len <= data_limit)
+	{
+		GAPBUFFER_TYPE *tmp = data_limit ? (GAPBUFFER_TYPE*)SRXK_REALLOC(
+				SRXK_ALLOC_GB_HISTORY, &gb->mem, h->data,
+				sizeof(GAPBUFFER_TYPE) * data_limit) : NULL;
+		if (tmp != NULL || data_limit == 0) {
+			if (tmp == NULL)
+				SRXK_FREE(SRXK_ALLOC_GB_HISTORY, &gb->mem, h->data);
+			h->data = tmp;
+			h->data_cap = (int)data_limit; }
+	}
+	size_t recs_limit = h->cap / sizeof(GAPBUFFER_HREC) + 1;
+	if ((size_t)h->recs_cap > recs_limit && (size_t)h->count <= recs_limit)
+	{
+		GAPBUFFER_HREC *tmp = (GAPBUFFER_HREC*)SRXK_REALLOC(SRXK_ALLOC_GB_HISTORY,
+				&gb->mem, h->recs, sizeof(GAPBUFFER_HREC) * recs_limit);
+		if (tmp != NULL) {
+			h->recs = tmp;
+			h->recs_cap = (int)recs_limit; }
+	}
+}
+
+static void function(history_trim)(GAPBUFFER *gb)
+{
+	GAPBUFFER_HIST *h = gb->history;
+	if (function(history_bytes)(h) <= h->cap) {
+		function(history_fit)(gb);
+		return; }
+
+	// Drop whole groups from the front until we are well under the cap, so
+	// that we aren't doing this again on the next edit
+	size_t target = h->cap - h->cap / 4;
+	size_t bytes = function(history_bytes)(h);
+	int k = 0;
+	while (k < h->count && (bytes > target
+			|| (k > 0 && h->recs[k].group == h->recs[k-1].group)))
+	{
+		bytes -= sizeof(GAPBUFFER_HREC) + sizeof(GAPBUFFER_TYPE)
+				* (size_t)h->recs[k].len;
+		++k;
+	}
+	// Redo records can't outlive the records they come after
+	if (k > h->applied)
+		k = h->count;
+
+	int off = k < h->count ? h->recs[k].off : h->data_len;
+	memmove(h->recs, h->recs + k, sizeof(GAPBUFFER_HREC) * (h->count - k));
+	memmove(h->data, h->data + off, sizeof(GAPBUFFER_TYPE)
+			* (h->data_len - off));
+	h->count -= k;
+	// If the redo records went too there is nothing left applied
+	h->applied = h->applied > k ? h->applied - k : 0;
+	h->data_len -= off;
+	for (int i = 0; i < h->count; ++i)
+		h->recs[i].off -= off;
+	if (h->count == 0)
+		h->open = 0;
+	function(history_fit)(gb);
+}
+
+// Forgets every record, for when the journal can't follow the buffer
+static void function(history_clear)(GAPBUFFER *gb)
+{
+	GAPBUFFER_HIST *h = gb->history;
+	h->count = 0;
+	h->applied = 0;
+	h->data_len = 0;
+	h->open = 0;
+	function(history_fit)(gb);
+}
+
+/*Returns 0 if the edit wasn't recorded, the edit has already been made by
+then so the journal is cleared rather then left out of step*/
+static int function(history_record)(GAPBUFFER *gb, int op, int pos,
+		const GAPBUFFER_TYPE *src, int len)
+{
+	GAPBUFFER_HIST *h = gb->history;
+	if (h == NULL || h->replaying || len <= 0)
+		return 1;
+
+	// A new edit throws away anything that could have been redone
+	if (h->applied < h->count)
+	{
+		h->count = h->applied;
+		h->data_len = h->count ? h->recs[h->count-1].off
+				+ h->recs[h->count-1].len : 0;
+		h->open = 0;
+	}
+
+	// A run that could never fit isn't recorded, and the edits before it
+	// can't be undone past it so they are forgotten too
+	if (sizeof(GAPBUFFER_HREC) + sizeof(GAPBUFFER_TYPE) * (size_t)len > h->cap)
+	{
+		function(history_clear)(gb);
+		return 0;
+	}
+
+	// Make sure there is room for the elements, growing no further then the
+	// cap unless this run needs it, the trim below brings it back under
+	if (h->data_len + len > h->data_cap)
+	{
+		int newsize = h->data_cap * 2 > h->data_len + len ? h->data_cap * 2
+				: h->data_len + len;
+		size_t data_limit = h->cap / sizeof(GAPBUFFER_TYPE);
+		if ((size_t)newsize > data_limit)
+			newsize = (size_t)(h->data_len + len) > data_limit
+					? h->data_len + len : (int)data_limit;
+		GAPBUFFER_TYPE *tmp = (GAPBUFFER_TYPE*)SRXK_REALLOC(SRXK_ALLOC_GB_HISTORY,
+				&gb->mem, h->data, sizeof(GAPBUFFER_TYPE) * newsize);
+		if (tmp == NULL) {
+			GAPBUFFER_ERR = ENOMEM;
+			function(history_clear)(gb);
+			return 0; }
+		h->data = tmp;
+		h->data_cap = newsize;
+	}
+
+	// Extend the last run if this edit carries straight on from it
+	GAPBUFFER_HREC *last = h->count ? &h->recs[h->count-1] : NULL;
+	if (!(h->open && last != NULL && last->op == op
+			&& (op == GAPBUFFER_OP_INSERT ? last->pos + last->len == pos
+			: pos + len == last->pos)))
+	{
+		if (h->count == h->recs_cap)
+		{
+			int newsize = h->recs_cap ? h->recs_cap * 2 : 16;
+			size_t recs_limit = h->cap / sizeof(GAPBUFFER_HREC) + 1;
+			if ((size_t)newsize > recs_limit)
+				newsize = (size_t)h->count + 1 > recs_limit ? h->count + 1
+						: (int)recs_limit;
+			GAPBUFFER_HREC *tmp = (GAPBUFFER_HREC*)SRXK_REALLOC(SRXK_ALLOC_GB_HISTORY,
+					&gb->mem, h->recs, sizeof(GAPBUFFER_HREC) * newsize);
+			if (tmp == NULL) {
+				GAPBUFFER_ERR = ENOMEM;
+				function(history_clear)(gb);
+				return 0; }
+			h->recs = tmp;
+			h->recs_cap = newsize;
+		}
+		last = &h->recs[h->count++];
+		last->op = op;
+		last->group = h->depth ? h->group : ++h->group;
+		last->pos = pos;
+		last->len = 0;
+		last->off = h->data_len;
+		h->open = 1;
+	}
+
+	// Inserted runs are stored in order, deleted runs back to front so that
+	// a run of backspaces only ever appends
+	if (op == GAPBUFFER_OP_INSERT)
+		memcpy(h->data + h->data_len, src, sizeof(GAPBUFFER_TYPE) * len);
+	else
+	{
+		for (int i = 0; i < len; ++i)
+			h->data[h->data_len + i] = src[len - 1 - i];
+		last->pos = pos;
+	}
+	h->data_len += len;
+	last->len += len;
+	h->applied = h->count;
+
+	function(history_trim)(gb);
+	return 1;
+}
+
+// Grows the gap so it holds more then need elements, 0 if it couldn't
+static int function(history_room)(GAPBUFFER *gb, int need)
+{
+	if (gb->gap_len <= need)
+		function(grow)(gb, need - gb->gap_len + GAPBUFFER_GROW_SIZE);
+	if (gb->gap_len <= need) {
+		GAPBUFFER_ERR = ENOMEM;
+		return 0; }
+	return 1;
+}
+
 /* 
 * Description:
 * 	Inserts a new element at the cursor, grows if needed
@@ -203,14 +622,17 @@ static void function(insert)(GAPBUFFER *gb, GAPBUFFER_TYPE data)
 	if (gb->gap_len == 0)
 	{
 		function(grow)(gb, GAPBUFFER_GROW_SIZE);
-		// Check that if there an error growing the buffer
-		if (GAPBUFFER_ERR == ENOMEM)
+		// Check if it failed to grow, GAPBUFFER_ERR could be left over from
+		// something else so look at the gap
+		if (gb->gap_len == 0)
 			return;
 	}
 	 
 	// Copy the data to the buffer
 	gb->buf[gb->gap_strt++] = data;
 	--gb->gap_len;
+	function(history_record)(gb, GAPBUFFER_OP_INSERT, gb->gap_strt - 1,
+			&data, 1);
 }
 
 /* 
@@ -229,8 +651,9 @@ static void function(inserts)(GAPBUFFER *gb, GAPBUFFER_TYPE *data, int len)
 	if (gb->gap_len-len <= 0)
 	{
 		function(grow)(gb, len);
-		// Check that if there an error growing the buffer
-		if (GAPBUFFER_ERR == ENOMEM)
+		// Check if it failed to grow, GAPBUFFER_ERR could be left over from
+		// something else so look at the gap
+		if (gb->gap_len < len)
 			return;
 	}
 	
@@ -240,6 +663,92 @@ static void function(inserts)(GAPBUFFER *gb, GAPBUFFER_TYPE *data, int len)
 		gb->buf[gb->gap_strt++] = data[i];
 		--gb->gap_len;	
 	}
+	function(history_record)(gb, GAPBUFFER_OP_INSERT, gb->gap_strt - len,
+			data, len);
+}
+
+/* 
+* Description:
+* 	Deletes the element before the cursor, like a backspace
+* Parameters:
+* 	GAPBUFFER *gb - The gap buffer to be operated on
+* Return Value:
+* 	None, if the cursor is at the start GAPBUFFER_ERR is set to ENODATA
+*/
+static void function(delete)(GAPBUFFER *gb)
+{
+	if (gb->gap_strt == 0) {
+		GAPBUFFER_ERR = ENODATA;
+		return; }
+
+	function(history_record)(gb, GAPBUFFER_OP_DELETE, gb->gap_strt - 1,
+			gb->buf + gb->gap_strt - 1, 1);
+	// Just widen the gap over it
+	--gb->gap_strt;
+	++gb->gap_len;
+	if (gb->gap_strt < gb->map_clean)
+		gb->map_clean = gb->gap_strt;
+}
+
+/* 
+* Description:
+* 	Deletes len elements before the cursor
+* Parameters:
+* 	GAPBUFFER *gb - The gap buffer to be operated on
+*  int len - The amount of elements to delete
+* Return Value:
+* 	None, if there are less then len elements before the cursor nothing is
+*  deleted and GAPBUFFER_ERR is set to ENODATA
+*/
+static void function(deletes)(GAPBUFFER *gb, int len)
+{
+	if (len < 0 || len > gb->gap_strt) {
+		GAPBUFFER_ERR = ENODATA;
+		return; }
+
+	function(history_record)(gb, GAPBUFFER_OP_DELETE, gb->gap_strt - len,
+			gb->buf + gb->gap_strt - len, len);
+	gb->gap_strt -= len;
+	gb->gap_len += len;
+	if (gb->gap_strt < gb->map_clean)
+		gb->map_clean = gb->gap_strt;
+}
+
+/* 
+* Description:
+* 	Moves the cursor to an index, the elements between the old and new
+*  cursor are moved across the gap in one go
+* Parameters:
+* 	GAPBUFFER *gb - The gap buffer to be operated on
+*  int pos - The index to move the cursor to
+* Return Value:
+* 	None, if pos is out of bounds GAPBUFFER_ERR is set to ENODATA
+*/
+static void function(move)(GAPBUFFER *gb, int pos)
+{
+	if (pos < 0 || pos > gb->len - gb->gap_len) {
+		GAPBUFFER_ERR = ENODATA;
+		return; }
+
+	#ifndef GAPBUFFER_NO_FILE
+		// The first move in a mapped file gets a chance to place the gap
+		if (gb->map_fd >= 0 && pos != gb->gap_strt)
+		{
+			int placed = pos < gb->gap_strt && function(place)(gb, pos);
+			close(gb->map_fd);
+			gb->map_fd = -1;
+			if (placed)
+				return;
+		}
+	#endif // GAPBUFFER_NO_FILE
+
+	if (pos < gb->gap_strt) // Move the elements before us to after the gap
+		memmove(gb->buf + pos + gb->gap_len, gb->buf + pos,
+				sizeof(GAPBUFFER_TYPE) * (gb->gap_strt - pos));
+	else // Move the elements after the gap to before it
+		memmove(gb->buf + gb->gap_strt, gb->buf + gb->gap_strt + gb->gap_len,
+				sizeof(GAPBUFFER_TYPE) * (pos - gb->gap_strt));
+	gb->gap_strt = pos;
 }
 
 /* 
@@ -266,6 +775,350 @@ static GAPBUFFER_TYPE function(index)(GAPBUFFER *gb, int index)
 		return gb->buf[index];
 }
 
+/* 
+* Description:
+* 	Gets the buffer for a kernel to work on, with GAPBUFFER_ALIGN the
+*  compiler is told that it is aligned. The elements before the gap start
+*  here, the ones after it start at gap_strt + gap_len
+* Parameters:
+* 	GAPBUFFER *gb - The gap buffer to be operated on
+* Return Value:
+* 	A pointer to the start of the buffer
+*/
+static GAPBUFFER_TYPE *function(data)(GAPBUFFER *gb)
+{
+#ifdef GAPBUFFER_ALIGN
+	return (GAPBUFFER_TYPE*)SRXK_ASSUME_ALIGNED(gb->buf, GAPBUFFER_ALIGN);
+#else
+	return gb->buf;
+#endif // GAPBUFFER_ALIGN
+}
+
+// JOURNAL FUNCTIONS
+/* 
+* Description:
+* 	Turns on the undo journal, or changes its memory cap if it is already on.
+*  The oldest edits are forgotten once the journal would use more then cap
+*  bytes, a cap of 0 turns the journal off and frees it
+* Parameters:
+* 	GAPBUFFER *gb - The gap buffer to be operated on
+*  size_t cap - The most bytes the journal may use
+* Return Value:
+* 	None
+*/
+static void function(journal)(GAPBUFFER *gb, size_t cap)
+{
+	GAPBUFFER_HIST *h = gb->history;
+	if (cap == 0)
+	{
+		if (h != NULL) {
+			SRXK_FREE(SRXK_ALLOC_GB_HISTORY, &gb->mem, h->recs);
+			SRXK_FREE(SRXK_ALLOC_GB_HISTORY, &gb->mem, h->data);
+			SRXK_FREE(SRXK_ALLOC_GB_HISTORY, &gb->mem, h); }
+		gb->history = NULL;
+		return;
+	}
+
+	if (h == NULL)
+	{
+		h = (GAPBUFFER_HIST*)SRXK_MALLOC(SRXK_ALLOC_GB_HISTORY, &gb->mem,
+				sizeof(GAPBUFFER_HIST));
+		if (h == NULL) {
+			GAPBUFFER_ERR = ENOMEM;
+			return; }
+		memset(h, 0, sizeof(GAPBUFFER_HIST));
+		gb->history = h;
+	}
+	h->cap = cap;
+	function(history_trim)(gb);
+}
+
+/* 
+* Description:
+* 	Stops the next edit from being merged into the last run, so they are
+*  undone separately
+* Parameters:
+* 	GAPBUFFER *gb - The gap buffer to be operated on
+* Return Value:
+* 	None
+*/
+static void function(seal)(GAPBUFFER *gb)
+{
+	if (gb->history != NULL)
+		gb->history->open = 0;
+}
+
+/* 
+* Description:
+* 	Starts a group, every edit until the matching group_end is undone and
+*  redone as one. Groups can be nested
+* Parameters:
+* 	GAPBUFFER *gb - The gap buffer to be operated on
+* Return Value:
+* 	None
+*/
+static void function(group_begin)(GAPBUFFER *gb)
+{
+	GAPBUFFER_HIST *h = gb->history;
+	if (h == NULL)
+		return;
+	if (h->depth++ == 0)
+		++h->group;
+	h->open = 0;
+}
+
+/* 
+* Description:
+* 	Ends a group started with group_begin
+* Parameters:
+* 	GAPBUFFER *gb - The gap buffer to be operated on
+* Return Value:
+* 	None
+*/
+static void function(group_end)(GAPBUFFER *gb)
+{
+	GAPBUFFER_HIST *h = gb->history;
+	if (h == NULL || h->depth == 0)
+		return;
+	--h->depth;
+	h->open = 0;
+}
+
+/* 
+* Description:
+* 	Undoes the last group of edits, each run costs the size of the run plus
+*  moving the cursor to it
+* Parameters:
+* 	GAPBUFFER *gb - The gap buffer to be operated on
+* Return Value:
+* 	1 if something was undone, 0 if there was nothing to undo. If the buffer
+*  can't grow enough for the group nothing is changed, 0 is returned and
+*  GAPBUFFER_ERR is set to ENOMEM
+*/
+static int function(undo)(GAPBUFFER *gb)
+{
+	GAPBUFFER_HIST *h = gb->history;
+	if (h == NULL || h->applied == 0)
+		return 0;
+
+	// Make room for every deleted run in the group first, so it can't fail
+	// half way through
+	int group = h->recs[h->applied-1].group;
+	int need = 0;
+	for (int k = h->applied - 1; k >= 0 && h->recs[k].group == group; --k)
+		if (h->recs[k].op == GAPBUFFER_OP_DELETE)
+			need += h->recs[k].len;
+	if (!function(history_room)(gb, need))
+		return 0;
+
+	h->replaying = 1;
+	h->open = 0;
+	while (h->applied > 0 && h->recs[h->applied-1].group == group)
+	{
+		GAPBUFFER_HREC *r = &h->recs[--h->applied];
+		if (r->op == GAPBUFFER_OP_INSERT)
+		{
+			function(move)(gb, r->pos + r->len);
+			function(deletes)(gb, r->len);
+		} else {
+			// Put the deleted run back, it is stored back to front
+			function(move)(gb, r->pos);
+			for (int i = r->len - 1; i >= 0; --i)
+				gb->buf[gb->gap_strt++] = h->data[r->off + i];
+			gb->gap_len -= r->len;
+		}
+	}
+	h->replaying = 0;
+	return 1;
+}
+
+/* 
+* Description:
+* 	Redoes the last group of edits that was undone
+* Parameters:
+* 	GAPBUFFER *gb - The gap buffer to be operated on
+* Return Value:
+* 	1 if something was redone, 0 if there was nothing to redo. If the buffer
+*  can't grow enough for the group nothing is changed, 0 is returned and
+*  GAPBUFFER_ERR is set to ENOMEM
+*/
+static int function(redo)(GAPBUFFER *gb)
+{
+	GAPBUFFER_HIST *h = gb->history;
+	if (h == NULL || h->applied == h->count)
+		return 0;
+
+	int group = h->recs[h->applied].group;
+	int need = 0;
+	for (int k = h->applied; k < h->count && h->recs[k].group == group; ++k)
+		if (h->recs[k].op == GAPBUFFER_OP_INSERT)
+			need += h->recs[k].len;
+	if (!function(history_room)(gb, need))
+		return 0;
+
+	h->replaying = 1;
+	h->open = 0;
+	while (h->applied < h->count && h->recs[h->applied].group == group)
+	{
+		GAPBUFFER_HREC *r = &h->recs[h->applied++];
+		if (r->op == GAPBUFFER_OP_INSERT)
+		{
+			function(move)(gb, r->pos);
+			function(inserts)(gb, h->data + r->off, r->len);
+		} else {
+			function(move)(gb, r->pos + r->len);
+			function(deletes)(gb, r->len);
+		}
+	}
+	h->replaying = 0;
+	return 1;
+}
+
+// BATCH EDIT HELPERS
+// You shouldn't be calling these for any good reason
+static int function(edit_cmp)(const void *a, const void *b)
+{
+	// Pure inserts go before a delete at the same position
+	const GAPBUFFER_EDIT *x = (const GAPBUFFER_EDIT*)a;
+	const GAPBUFFER_EDIT *y = (const GAPBUFFER_EDIT*)b;
+	if (x->pos != y->pos)
+		return x->pos < y->pos ? -1 : 1;
+	return (x->del > y->del) - (x->del < y->del);
+}
+
+// Copies n elements of text starting at pos, act like the gap doesnt exist
+static void function(copy_text)(GAPBUFFER *gb, GAPBUFFER_TYPE *dst, int pos,
+		int n)
+{
+	if (pos < gb->gap_strt)
+	{
+		int before = gb->gap_strt - pos < n ? gb->gap_strt - pos : n;
+		memcpy(dst, gb->buf + pos, sizeof(GAPBUFFER_TYPE) * before);
+		dst += before;
+		pos += before;
+		n -= before;
+	}
+	memcpy(dst, gb->buf + gb->gap_len + pos, sizeof(GAPBUFFER_TYPE) * n);
+}
+
+/* 
+* Description:
+* 	Applies a batch of edits in one pass, each one deletes del elements at
+*  pos and inserts len elements from data in their place. Positions are all
+*  in the text from before the batch, so the edits don't shift each other.
+*  edits is sorted by position in place, and the text is rebuilt into a new
+*  buffer with bulk copies, so the batch costs the size of the buffer plus
+*  what is inserted no matter how many edits there are. The cursor ends up
+*  after the last edit, and with the journal on the batch is undone as one
+* Parameters:
+* 	GAPBUFFER *gb - The gap buffer to be operated on
+*  GAPBUFFER_EDIT *edits - The edits to apply
+*  int n - How many edits there are
+* Return Value:
+* 	0 on success, otherwise -1 and nothing is changed. GAPBUFFER_ERR is set to
+*  EINVAL if an edit is out of bounds, overlaps another or two edits insert at
+*  the same position, or ENOMEM
+*/
+static int function(apply_edits)(GAPBUFFER *gb, GAPBUFFER_EDIT *edits, int n)
+{
+	if (n <= 0)
+		return 0;
+
+	// Most batches come from a search so they are already in order
+	int sorted = 1;
+	for (int i = 1; i < n && sorted; ++i)
+		sorted = function(edit_cmp)(&edits[i-1], &edits[i]) <= 0;
+	if (!sorted)
+		qsort(edits, (size_t)n, sizeof(GAPBUFFER_EDIT), function(edit_cmp));
+
+	// Check the whole batch before touching anything
+	int text = gb->len - gb->gap_len;
+	long long new_text = text;
+	for (int i = 0; i < n; ++i)
+	{
+		GAPBUFFER_EDIT *e = &edits[i];
+		if (e->pos < 0 || e->del < 0 || e->len < 0 || e->del > text - e->pos
+				|| (e->len > 0 && e->data == NULL)
+				|| (i > 0 && (edits[i-1].pos + edits[i-1].del > e->pos
+				|| (edits[i-1].pos == e->pos && e->del == 0)))) {
+			GAPBUFFER_ERR = EINVAL;
+			return -1; }
+		new_text += e->len - e->del;
+	}
+	if (new_text > INT_MAX - GAPBUFFER_GROW_SIZE) {
+		GAPBUFFER_ERR = ENOMEM;
+		return -1; }
+
+	// Keep at least as much room as we had, the gap goes after the last edit
+	int size = (int)new_text + GAPBUFFER_GROW_SIZE > gb->len
+			? (int)new_text + GAPBUFFER_GROW_SIZE : gb->len;
+	size = GAPBUFFER_PAD(size);
+	GAPBUFFER_TYPE *tmp = (GAPBUFFER_TYPE*)GAPBUFFER_ALLOC(&gb->mem,
+			sizeof(GAPBUFFER_TYPE) * size);
+	if (tmp == NULL) {
+		GAPBUFFER_ERR = ENOMEM;
+		return -1; }
+
+	// Copy the text between the edits and the inserts in order, the journal
+	// gets each edit where it lands after the ones before it
+	// Once an edit can't be recorded the journal is cleared, so stop
+	// recording or the rest of the batch would be undone on its own
+	function(group_begin)(gb);
+	int journal = gb->history != NULL;
+	GAPBUFFER_TYPE *dst = tmp;
+	int from = 0;
+	for (int i = 0; i < n; ++i)
+	{
+		GAPBUFFER_EDIT *e = &edits[i];
+		function(copy_text)(gb, dst, from, e->pos - from);
+		dst += e->pos - from;
+		int at = (int)(dst - tmp);
+
+		if (journal && e->del > 0)
+		{
+			// A deleted run can straddle the gap, so record it in two pieces
+			// back to front, they merge like a run of backspaces
+			int split = e->pos < gb->gap_strt && gb->gap_strt < e->pos + e->del
+					? gb->gap_strt - e->pos : 0;
+			if (split > 0)
+				journal = function(history_record)(gb, GAPBUFFER_OP_DELETE,
+						at + split, gb->buf + gb->gap_strt + gb->gap_len,
+						e->del - split)
+						&& function(history_record)(gb, GAPBUFFER_OP_DELETE, at,
+						gb->buf + e->pos, split);
+			else
+				journal = function(history_record)(gb, GAPBUFFER_OP_DELETE, at,
+						gb->buf + e->pos + (e->pos < gb->gap_strt ? 0
+						: gb->gap_len), e->del);
+		}
+		if (journal)
+			journal = function(history_record)(gb, GAPBUFFER_OP_INSERT, at,
+					e->data, e->len);
+
+		if (e->len > 0)
+			memcpy(dst, e->data, sizeof(GAPBUFFER_TYPE) * e->len);
+		dst += e->len;
+		from = e->pos + e->del;
+	}
+	function(group_end)(gb);
+
+	// The rest of the text goes after the gap
+	int cursor = (int)(dst - tmp);
+	int rest = text - from;
+	function(copy_text)(gb, tmp + size - rest, from, rest);
+
+	if (gb->map != NULL)
+		function(unmap)(gb);
+	else
+		GAPBUFFER_FREE(&gb->mem, gb->buf);
+
+	gb->buf = tmp;
+	gb->len = size;
+	gb->gap_strt = cursor;
+	gb->gap_len = size - rest - cursor;
+	return 0;
+}
+
 /* 
 * Description:
 * 	Free's a heap allocated gap buffer
@@ -276,14 +1129,264 @@ static GAPBUFFER_TYPE function(index)(GAPBUFFER *gb, int index)
 */
 static void function(free)(GAPBUFFER *gb)
 {
-	free(gb->buf);
-	free(gb);
+	if (gb->map != NULL)
+		function(unmap)(gb);
+	else
+		GAPBUFFER_FREE(&gb->mem, gb->buf);
+	function(journal)(gb, 0);
+	SRXK_FREE(SRXK_ALLOC_GAPBUFFER, NULL, gb);
+}
+
+#ifdef SRXK_TRACK_ALLOC
+/* 
+* Description:
+* 	Gets how many bytes of heap the gap buffer has allocated, its self and
+*  the journal included. A mapped file isn't counted until it is copied
+* Parameters:
+* 	const GAPBUFFER *gb - The gap buffer to be operated on
+* Return Value:
+* 	The live bytes, gb->mem has the rest of the counts
+*/
+static size_t function(memory_usage)(const GAPBUFFER *gb)
+{
+	return gb->mem.live;
+}
+#endif // SRXK_TRACK_ALLOC
+
+#ifndef GAPBUFFER_NO_FILE
+// FILE FUNCTIONS
+/* 
+* Description:
+* 	Maps a file into a new gap buffer without reading it, pages are only
+*  faulted in as they are looked at and only copied once they are written to.
+*  The cursor starts at the end of the file, in front of an anonymous
+*  reservation of GAPBUFFER_MAP_RESERVE elements. The first time the cursor
+*  moves away the gap is placed there by mapping the rest of the file again
+*  after it, so nothing is copied and only the pages edited get written. The
+*  file is kept open until then. The buffer is copied to the heap once the
+*  gap is used up. Trailing bytes that don't make up a whole element are
+*  ignored
+* Parameters:
+* 	const char *path - The path of the file to open
+* Return Value:
+* 	Returns the new gap buffer, or NULL and sets GAPBUFFER_ERR to errno
+*/
+static GAPBUFFER *function(open_file)(const char *path)
+{
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		GAPBUFFER_ERR = errno;
+		return NULL; }
+
+	struct stat st;
+	if (fstat(fd, &st) < 0) {
+		GAPBUFFER_ERR = errno;
+		close(fd);
+		return NULL; }
+
+	// len is an int, so the whole mapping has to fit in INT_MAX elements
+	// once it is rounded to pages. Near the limit the gap is cut short
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	size_t max_size = ((size_t)-1 / sizeof(GAPBUFFER_TYPE) < (size_t)INT_MAX
+			? (size_t)-1 : (size_t)INT_MAX * sizeof(GAPBUFFER_TYPE)) & ~(page - 1);
+	if ((unsigned long long)st.st_size > max_size) {
+		GAPBUFFER_ERR = EFBIG;
+		close(fd);
+		return NULL; }
+	size_t count = (size_t)st.st_size / sizeof(GAPBUFFER_TYPE);
+
+	// Reserve the file and the gap in one go, then map the file over the front
+	size_t file_size = (count * sizeof(GAPBUFFER_TYPE) + page - 1) & ~(page-1);
+	size_t reserve = (size_t)GAPBUFFER_MAP_RESERVE * sizeof(GAPBUFFER_TYPE);
+	size_t map_size = max_size - file_size < reserve ? max_size
+			: (file_size + reserve + page - 1) & ~(page - 1);
+	void *map = mmap(NULL, map_size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (map == MAP_FAILED) {
+		GAPBUFFER_ERR = errno;
+		close(fd);
+		return NULL; }
+	if (file_size && mmap(map, file_size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+		GAPBUFFER_ERR = errno;
+		munmap(map, map_size);
+		close(fd);
+		return NULL; }
+
+	GAPBUFFER *gb = (GAPBUFFER*)SRXK_MALLOC(SRXK_ALLOC_GAPBUFFER, NULL,
+			sizeof(GAPBUFFER));
+	if (gb == NULL) {
+		GAPBUFFER_ERR = ENOMEM;
+		munmap(map, map_size);
+		close(fd);
+		return NULL; }
+	SRXK_ALLOC_OWN(&gb->mem, gb);
+
+	gb->buf = (GAPBUFFER_TYPE*)map;
+	gb->len = (int)(map_size / sizeof(GAPBUFFER_TYPE));
+	gb->gap_strt = (int)count;
+	gb->gap_len = gb->len - (int)count;
+	gb->map = map;
+	gb->map_size = map_size;
+	gb->map_fd = fd;
+	gb->map_clean = (int)count;
+	gb->history = NULL;
+	return gb;
+}
+
+// You shouldn't be calling this for any good reason
+static int function(write_all)(int fd, const GAPBUFFER_TYPE *data, int len)
+{
+	const char *p = (const char*)data;
+	size_t left = sizeof(GAPBUFFER_TYPE) * (size_t)len;
+	while (left > 0)
+	{
+		ssize_t n = write(fd, p, left);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			GAPBUFFER_ERR = errno;
+			return -1; }
+		p += n;
+		left -= (size_t)n;
+	}
+	return 0;
+}
+
+/* 
+* Description:
+* 	Writes the contents of the gap buffer to a file descriptor, the text
+*  either side of the gap is written straight from the buffer
+* Parameters:
+* 	GAPBUFFER *gb - The gap buffer to be operated on
+*  int fd - The file descriptor to write to
+* Return Value:
+* 	0 on success, otherwise -1 and GAPBUFFER_ERR is set to errno
+*/
+static int function(write)(GAPBUFFER *gb, int fd)
+{
+	int after = gb->gap_strt + gb->gap_len;
+	if (function(write_all)(fd, gb->buf, gb->gap_strt) < 0)
+		return -1;
+	return function(write_all)(fd, gb->buf + after, gb->len - after);
+}
+
+/* 
+* Description:
+* 	Saves the gap buffer to a file, it is written to a temporary file next to
+*  path, fsync'd and then renamed over path so the file is never left half
+*  written. The directory is fsync'd after the rename so the new file
+*  survives a crash. It keeps the mode of the file it replaces, a new file
+*  gets 0666 less the umask. A symlink is followed and the file it points at
+*  is replaced, unless it points nowhere in which case the link itself is.
+*  It is safe to save over the file the buffer was opened from
+* Parameters:
+* 	GAPBUFFER *gb - The gap buffer to be operated on
+*  const char *path - The path of the file to save to
+* Return Value:
+* 	0 on success, otherwise -1 and GAPBUFFER_ERR is set to errno. If only
+*  the directory fsync fails the file has already been replaced
+*/
+static int function(save)(GAPBUFFER *gb, const char *path)
+{
+	// Save through a symlink to the file it points at, otherwise the rename
+	// would put a regular file in place of the link
+	char *real = realpath(path, NULL);
+	if (real != NULL)
+		path = real;
+
+	// Build our temporary file name
+	size_t path_len = strlen(path);
+	char *tmp = (char*)SRXK_MALLOC(SRXK_ALLOC_GAPBUFFER, &gb->mem,
+			path_len + sizeof(".XXXXXX"));
+	if (tmp == NULL) {
+		GAPBUFFER_ERR = ENOMEM;
+		free(real);
+		return -1; }
+	memcpy(tmp, path, path_len);
+	tmp[path_len] = '.';
+	tmp[path_len + 7] = '\0';
+
+	// Created with 0666 so the kernel takes the umask off a new file, a name
+	// that is already taken just gets another go
+	static unsigned int seed = 0;
+	unsigned int x = seed ^ ((unsigned int)getpid() * 2654435761u);
+	int fd = -1;
+	for (int tries = 0; fd < 0 && tries < 100; ++tries)
+	{
+		x = x * 1103515245u + 12345u;
+		unsigned int n = x;
+		for (int i = 1; i <= 6; ++i, n /= 36)
+			tmp[path_len + i] = "0123456789abcdefghijklmnopqrstuvwxyz"[n % 36];
+		fd = open(tmp, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+		if (fd < 0 && errno != EEXIST)
+			break;
+	}
+	seed = x;
+	if (fd < 0) {
+		GAPBUFFER_ERR = errno;
+		SRXK_FREE(SRXK_ALLOC_GAPBUFFER, &gb->mem, tmp);
+		free(real);
+		return -1; }
+
+	// Keep the permissions of the file we are replacing
+	struct stat st;
+	if (stat(path, &st) == 0)
+		fchmod(fd, st.st_mode & 07777);
+
+	if (function(write)(gb, fd) < 0 || fsync(fd) < 0)
+	{
+		GAPBUFFER_ERR = errno;
+		close(fd);
+		unlink(tmp);
+		SRXK_FREE(SRXK_ALLOC_GAPBUFFER, &gb->mem, tmp);
+		free(real);
+		return -1;
+	}
+	if (close(fd) < 0 || rename(tmp, path) < 0) {
+		GAPBUFFER_ERR = errno;
+		unlink(tmp);
+		SRXK_FREE(SRXK_ALLOC_GAPBUFFER, &gb->mem, tmp);
+		free(real);
+		return -1; }
+	free(real); // realpath uses malloc, not our allocator
+
+	// The rename is only durable once the directory is written out, tmp is
+	// cut down to the directory's path for this
+	char *slash = strrchr(tmp, '/');
+	if (slash == NULL)
+		memcpy(tmp, ".", 2);
+	else if (slash == tmp)
+		slash[1] = '\0'; // The root directory
+	else
+		*slash = '\0';
+	int dir = open(tmp, O_RDONLY);
+	SRXK_FREE(SRXK_ALLOC_GAPBUFFER, &gb->mem, tmp);
+	if (dir < 0) {
+		GAPBUFFER_ERR = errno;
+		return -1; }
+	// Some file systems can't fsync a directory, they say so with EINVAL
+	if (fsync(dir) < 0 && errno != EINVAL) {
+		GAPBUFFER_ERR = errno;
+		close(dir);
+		return -1; }
+	close(dir);
+	return 0;
 }
+#endif // GAPBUFFER_NO_FILE
 
 // Undefine the macros to keep things clean
 #undef GAPBUFFER
 #undef GAPBUFFER_TYPE
 #undef GAPBUFFER_ERR
+#undef GAPBUFFER_HIST
+#undef GAPBUFFER_HREC
+#undef GAPBUFFER_EDIT
+#undef GAPBUFFER_ALIGN
+#undef GAPBUFFER_PAD
+#undef GAPBUFFER_ALLOC
+#undef GAPBUFFER_REALLOC
+#undef GAPBUFFER_FREE
 #undef PASTER
 #undef EVALUATOR
 #undef function
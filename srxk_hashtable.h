@@ -1,5 +1,5 @@
 /*
-'* >> srxk_hashtable.h 0.1.0
+'* >> srxk_hashtable.h 0.5.0
 * A generic C header only hash table implementation
 * This is an open addressing double hashing table
 *
@@ -15,9 +15,33 @@
 * You can allow define if the value should be freed by defining `HT_FREEVALUE`
 * the default behaviour is to not free the value
 *
+* Defining `HT_CACHE` turns the table into a bounded cache, create it with
+* `ht_<type>_cache_new(max_count, max_bytes)` and once either budget is full
+* inserts evict the least recently used items using CLOCK. `HT_VALUESIZE(v)`
+* can be defined to count the bytes a value points to towards the budget.
+* Hits, misses and evictions are counted in the table
+*
+* Defining `HT_BLOOM` keeps a blocked bloom filter (srxk_bloom.h) of the keys
+* next to the table, so most searches for missing keys are answered after
+* looking at one cache line. It is rebuilt when the table resizes or once
+* enough keys have been deleted
+*
+* Defining `HT_STATIC_CAPACITY N` makes a table that never allocates. N must
+* be a power of two, the buckets and keys are stored in the struct so it can
+* live on the stack, in a global or inside another struct. Keys are copied
+* into `HT_STATIC_KEYLEN` bytes inline (32 by default, the null included),
+* longer keys set the error to ENAMETOOLONG and inserts into a full table set
+* it to ENOSPC. Set it up once with `ht_<type>_init(ht)`, after that
+* `ht_<type>_reset(ht)` empties it in O(1) so it can be reused per request.
+* Deleted buckets are cleared out by rehashing in place. It can't be used
+* with HT_FREEVALUE, HT_CACHE or HT_BLOOM. To have a fixed and a growing table
+* of one type, typedef a second name for it
+*
 * Custom memory allocators are also supported via by defining CUSTOM_MALLOC, 
 * _REALLOC, *_FREE
 * If an error ocurrs an errno will be set relative the ht type convention
+* Define SRXK_TRACK_ALLOC to count the memory tables use, with items and keys
+* counted apart from the buckets, see srxk_alloc.h
 *
 * There some examples in `test/` if you need a guide
 *
@@ -46,12 +70,20 @@ extern "C" {
 
 // INCLUDES
 #include <stdlib.h> // malloc, calloc, free
-#include <string.h> // strdup, strlen
-#include <math.h> // pow
+#include <string.h> // memcpy, strcmp, strlen
+#ifdef HT_BLOOM
+	#include "srxk_bloom.h"
+#endif // HT_BLOOM
 
 // CONSTANTS
 // These can be tweaked for your needs
-
+#ifndef HT_START_CAPACITY
+	#define HT_START_CAPACITY 53
+#endif // HT_START_CAPACITY
+/*The table grows once this percent of buckets are full or deleted*/
+#ifndef HT_MAX_LOAD
+	#define HT_MAX_LOAD 70
+#endif // HT_MAX_LOAD
 
 // THE MACRO MAGIC
 #ifndef HT_TYPE
@@ -61,6 +93,21 @@ extern "C" {
 #ifndef HT_EMPTYVALUE
 	#error "HT_EMPTYVALUE must be defined"
 #endif
+#if defined(HT_CACHE) && !defined(HT_VALUESIZE)
+	#define HT_VALUESIZE(v) 0
+#endif
+#ifdef HT_STATIC_CAPACITY
+	#if HT_STATIC_CAPACITY < 2 || (HT_STATIC_CAPACITY & (HT_STATIC_CAPACITY-1))
+		#error "HT_STATIC_CAPACITY must be a power of two"
+	#endif
+	#if defined(HT_FREEVALUE) || defined(HT_CACHE) || defined(HT_BLOOM)
+		#error "HT_STATIC_CAPACITY can't be used with HT_FREEVALUE, HT_CACHE or\
+				HT_BLOOM"
+	#endif
+	#ifndef HT_STATIC_KEYLEN
+		#define HT_STATIC_KEYLEN 32
+	#endif
+#endif // HT_STATIC_CAPACITY
 
 #define PASTER(x,y) x ## _ ## y
 #define EVALUATOR(x,y)  PASTER(x,y)
@@ -84,15 +131,256 @@ extern "C" {
 	#define realloc CUSTOM_REALLOC
 	#define free CUSTOM_FREE
 #endif
+#include "srxk_alloc.h"
 
 // ERROR CODES
 #ifndef ENOMEM
 	#define ENOMEM 12
 #endif
+#ifndef ENOSPC
+	#define ENOSPC 28
+#endif
+#ifndef ENAMETOOLONG
+	#define ENAMETOOLONG 36
+#endif
 #ifndef ENODATA
 	#define ENODATA 61
 #endif
 
+#ifdef HT_STATIC_CAPACITY
+// BUCKET STATES
+/*The low bits of a stamp, the rest is the generation it was written in*/
+#ifndef HT_STAMP_FULL
+	#define HT_STAMP_FULL 1
+	#define HT_STAMP_DELETED 2
+	#define HT_STAMP_GEN 4
+#endif // HT_STAMP_FULL
+
+// HASH TABLE ITEM
+typedef struct HT_ITEM
+{
+	char k[HT_STATIC_KEYLEN];
+	HT_TYPE v;
+} HT_ITEM;
+
+// HASH TABLE TYPE
+typedef struct HT
+{
+	HT_ITEM data[HT_STATIC_CAPACITY];
+	/*A bucket is only in use if its stamp is from the current generation,
+	so moving to the next one empties every bucket at once*/
+	unsigned int stamp[HT_STATIC_CAPACITY];
+	unsigned int gen;
+	int capacity;
+	int count;
+	int deleted; // Buckets deleted since the last rehash
+} HT;
+
+// ERROR NUMBER
+static int HT_ERR = 0;
+
+// HASH FUNCTIONS
+// You shouldn't be calling these for any good reason
+/*FNV-1a, which also measures the key so it only has to be read once*/
+static unsigned int function(static_hash)(const char *k, size_t *len)
+{
+	unsigned int h = 2166136261u;
+	const char *p = k;
+	for (; *p != '\0'; ++p)
+		h = (h ^ (unsigned char)*p) * 16777619u;
+	*len = (size_t)(p - k);
+	return h;
+}
+
+/*Returns the bucket holding key, or -1 with free set to the first bucket it
+could go in, or -1 if there isn't one. The step is odd so it is coprime with
+the capacity and every bucket gets visited*/
+static int function(static_find)(const HT *ht, const char *key, size_t len,
+		unsigned int h, int *free_b)
+{
+	const unsigned int mask = HT_STATIC_CAPACITY - 1;
+	unsigned int step = ((h >> 16) | 1) & mask;
+	unsigned int index = h & mask;
+	*free_b = -1;
+	for (int i = 0; i < HT_STATIC_CAPACITY; ++i, index = (index + step) & mask)
+	{
+		unsigned int stamp = ht->stamp[index];
+		if ((stamp & ~(HT_STAMP_GEN - 1)) != ht->gen) {
+			// Empty, so the key can't be any further on
+			if (*free_b < 0)
+				*free_b = (int)index;
+			return -1; }
+		if (stamp & HT_STAMP_DELETED) {
+			if (*free_b < 0)
+				*free_b = (int)index;
+		} else if (!memcmp(ht->data[index].k, key, len + 1))
+			return (int)index;
+	}
+	return -1;
+}
+
+/*Rehashes in place, as there is nowhere else to put the items. The live
+buckets are marked with both bits, then each one is moved to where it would
+go in an empty table. A marked bucket in the way is swapped out and moved next*/
+static void function(static_rehash)(HT *ht)
+{
+	const unsigned int mask = HT_STATIC_CAPACITY - 1;
+	const unsigned int full = ht->gen | HT_STAMP_FULL;
+	const unsigned int moving = full | HT_STAMP_DELETED;
+	for (int i = 0; i < HT_STATIC_CAPACITY; ++i)
+		ht->stamp[i] = ht->stamp[i] == full ? moving : 0;
+
+	for (int i = 0; i < HT_STATIC_CAPACITY; ++i)
+	{
+		if (ht->stamp[i] != moving)
+			continue;
+		HT_ITEM it = ht->data[i];
+		ht->stamp[i] = 0;
+		for (;;)
+		{
+			size_t len;
+			unsigned int h = function(static_hash)(it.k, &len);
+			unsigned int step = ((h >> 16) | 1) & mask;
+			unsigned int index = h & mask;
+			while (ht->stamp[index] == full)
+				index = (index + step) & mask;
+
+			HT_ITEM next = ht->data[index];
+			int more = ht->stamp[index] == moving;
+			ht->data[index] = it;
+			ht->stamp[index] = full;
+			if (!more)
+				break;
+			it = next;
+		}
+	}
+	ht->deleted = 0;
+}
+
+// HASH TABLE FUNCTIONS
+/* 
+* Description:
+* 	Sets up a fixed table, this clears the stamps once so it is O(N). Use
+*  reset to empty it after that
+* Parameters:
+* 	HT *ht - the hash table to be operated on
+* Return Value:
+* 	The table operated on
+*/
+static HT *function(init)(HT *ht)
+{
+	memset(ht->stamp, 0, sizeof(ht->stamp));
+	ht->gen = HT_STAMP_GEN;
+	ht->capacity = HT_STATIC_CAPACITY;
+	ht->count = 0;
+	ht->deleted = 0;
+	return ht;
+}
+
+/* 
+* Description:
+* 	Empties a fixed table in O(1) by starting a new generation, the stamps
+*  are only cleared again once the generation wraps around
+* Parameters:
+* 	HT *ht - the hash table to be operated on
+* Return Value:
+* 	None
+*/
+static void function(reset)(HT *ht)
+{
+	ht->gen += HT_STAMP_GEN;
+	if (ht->gen == 0) {
+		memset(ht->stamp, 0, sizeof(ht->stamp));
+		ht->gen = HT_STAMP_GEN; }
+	ht->count = 0;
+	ht->deleted = 0;
+}
+
+/* 
+* Description:
+* 	Inserts a value, or updates it if the key is already in the table
+* Parameters:
+* 	HT *ht - the hash table to be operated on
+* 	const char *key - the key, this is copied into the bucket
+* 	const HT_TYPE value - the value to store
+* Return Value:
+* 	None, sets HT_ERR to ENAMETOOLONG if the key doesn't fit in
+* 	HT_STATIC_KEYLEN or ENOSPC if the table is full
+*/
+static void function(insert)(HT *ht, const char *key, const HT_TYPE value)
+{
+	size_t len;
+	unsigned int h = function(static_hash)(key, &len);
+	if (len >= HT_STATIC_KEYLEN) {
+		HT_ERR = ENAMETOOLONG;
+		return;}
+
+	int free_b;
+	int index = function(static_find)(ht, key, len, h, &free_b);
+	if (index >= 0) {
+		ht->data[index].v = value;
+		return;}
+	if (free_b < 0) {
+		HT_ERR = ENOSPC;
+		return;}
+
+	if (ht->stamp[free_b] & HT_STAMP_DELETED && (ht->stamp[free_b]
+			& ~(HT_STAMP_GEN - 1)) == ht->gen)
+		--ht->deleted;
+	memcpy(ht->data[free_b].k, key, len + 1);
+	ht->data[free_b].v = value;
+	ht->stamp[free_b] = ht->gen | HT_STAMP_FULL;
+	++ht->count;
+}
+
+/* 
+* Description:
+* 	Finds the value stored under a key
+* Parameters:
+* 	const HT *ht - the hash table to be operated on
+* 	const char *key - the key to look for
+* Return Value:
+* 	The value, or HT_EMPTYVALUE and sets HT_ERR to ENODATA if it isn't found
+*/
+static HT_TYPE function(search)(const HT *ht, const char *key)
+{
+	size_t len;
+	unsigned int h = function(static_hash)(key, &len);
+	int free_b;
+	int index = len < HT_STATIC_KEYLEN ? function(static_find)(ht, key, len,
+			h, &free_b) : -1;
+	if (index < 0) {
+		HT_ERR = ENODATA;
+		return HT_EMPTYVALUE;}
+	return ht->data[index].v;
+}
+
+/* 
+* Description:
+* 	Removes a key and its value from the table. Once deleted buckets are
+*  more then half of the buckets without a key the table is rehashed in
+*  place, so a search for a missing key still hits an empty bucket soon
+* Parameters:
+* 	HT *ht - the hash table to be operated on
+* 	const char *key - the key to remove
+* Return Value:
+* 	None
+*/
+static void function(delete)(HT *ht, const char *key)
+{
+	size_t len;
+	unsigned int h = function(static_hash)(key, &len);
+	int free_b;
+	int index = len < HT_STATIC_KEYLEN ? function(static_find)(ht, key, len,
+			h, &free_b) : -1;
+	if (index < 0)
+		return;
+	ht->stamp[index] = ht->gen | HT_STAMP_DELETED;
+	--ht->count;
+	if (++ht->deleted > (HT_STATIC_CAPACITY - ht->count) / 2)
+		function(static_rehash)(ht);
+}
+#else
 // HASH TABLE ITEM
 typedef struct HT_ITEM
 {
@@ -106,6 +394,24 @@ typedef struct HT
 	HT_ITEM **data;
 	int capacity;
 	int count;
+	int deleted; // Buckets holding HT_EMPTY
+#ifdef HT_CACHE
+	unsigned char *ref; // CLOCK reference bit for each bucket
+	int hand;
+	int max_count; // 0 for no limit
+	size_t max_bytes; // 0 for no limit
+	size_t bytes;
+	long hits;
+	long misses;
+	long evictions;
+#endif // HT_CACHE
+#ifdef HT_BLOOM
+	srxk_bloom *filter;
+	int stale; // Keys deleted since the filter was built
+#endif // HT_BLOOM
+#ifdef SRXK_TRACK_ALLOC
+	srxk_alloc_stats mem; // The filter counts its own
+#endif // SRXK_TRACK_ALLOC
 } HT;
 
 // ERROR NUMBER
@@ -118,44 +424,137 @@ static HT_ITEM HT_EMPTY = {NULL, HT_EMPTYVALUE};
 // The reason I use function() is to avoid namespace collision w/ users program
 static int function(gen_hash)(const char* k, const int p, const int m)
 {
+	// Horner's rule, same polynomial as summing p^(len-i-1) * k[i] but it
+	// never overflows
 	long hash = 0;
-	const int len = strlen(k);
-	for (int i = 0; i < len; ++i)
-	{
-		hash += (long)pow(p, len - (i+1)) * k[i];
-		hash %= m;
-	}
+	for (; *k != '\0'; ++k)
+		hash = (hash * p + (unsigned char)*k) % m;
 	return (int)hash;
 }
-static int function(hash)(const char* k, const int num_b, const int a)
+/*Returns the first bucket to probe and sets step to how far to move on each
+probe after, the capacity is always prime so the step is coprime with it and
+every bucket gets visited*/
+static int function(hash)(const char* k, const int num_b, int *step)
+{
+	*step = function(gen_hash)(k, 149, num_b - 1) + 1;
+	return function(gen_hash)(k, 151, num_b);
+}
+static int function(next_prime)(int n)
 {
-	int ha = function(gen_hash)(k, 151, num_b);
-	int hb = function(gen_hash)(k, 149, num_b);
-	return (ha + (a * (hb + 1))) & num_b;
+	if (n < 3)
+		return 3;
+	n |= 1;
+	for (;; n += 2)
+	{
+		int prime = 1;
+		for (int d = 3; d <= n / d; d += 2)
+			if (n % d == 0) {
+				prime = 0;
+				break; }
+		if (prime)
+			return n;
+	}
 }
 
 // HASH TABLE ITEM FUNCTIONS
 // You shouldn't be calling these for any good reason
-static HT_ITEM *function(item_new)(const char *k, HT_TYPE v)
+static HT_ITEM *function(item_new)(HT *ht, const char *k, HT_TYPE v)
 {
-	// Create a new item, copy the key and value
-	HT_ITEM *t = malloc(sizeof(HT_ITEM));
-	t->k = strdup(k);
+	(void)ht;
+	// Create a new item, copy the key and value. strdup would skip the
+	// custom allocator, so the key is copied by hand
+	HT_ITEM *t = (HT_ITEM*)SRXK_MALLOC(SRXK_ALLOC_HT_ITEM, &ht->mem,
+			sizeof(HT_ITEM));
+	if (t == NULL)
+		return NULL;
+	size_t len = strlen(k) + 1;
+	t->k = (char*)SRXK_MALLOC(SRXK_ALLOC_HT_KEY, &ht->mem, len);
+	if (t->k == NULL) {
+		SRXK_FREE(SRXK_ALLOC_HT_ITEM, &ht->mem, t);
+		return NULL; }
+	memcpy(t->k, k, len);
 	t->v = v;
 	return t;
 }
 
-static void function(item_free)(HT_ITEM *i)
+static void function(item_free)(HT *ht, HT_ITEM *i)
 {
+	(void)ht;
 	// Free key and item
-	free(i->k);
-	// Free value if behaviour is defined
+	SRXK_FREE(SRXK_ALLOC_HT_KEY, &ht->mem, i->k);
+	// Free value if behaviour is defined, the user allocated it
 	#ifdef HT_FREEVALUE
-		free(->v);
+		free(i->v);
 	#endif 
-	free(i);
+	SRXK_FREE(SRXK_ALLOC_HT_ITEM, &ht->mem, i);
+}
+
+#ifdef HT_BLOOM
+static void function(bloom_rebuild)(HT *ht)
+{
+	// Size it for as many keys as the table can hold before it grows
+	srxk_bloom *filter = srxk_bloom_new((int)((long)ht->capacity * HT_MAX_LOAD
+			/ 100));
+	if (filter == NULL) // The old filter still has every key in it
+		return;
+	for (int i = 0; i < ht->capacity; ++i)
+	{
+		HT_ITEM *it = ht->data[i];
+		if (it != NULL && it != &HT_EMPTY)
+			srxk_bloom_add(filter, it->k);
+	}
+	if (ht->filter != NULL)
+		srxk_bloom_free(ht->filter);
+	ht->filter = filter;
+	ht->stale = 0;
 }
 
+static void function(bloom_forget)(HT *ht)
+{
+	// Deleted keys can't be taken out, so rebuild once enough pile up
+	if (++ht->stale > ht->capacity / 4)
+		function(bloom_rebuild)(ht);
+}
+#endif // HT_BLOOM
+
+#ifdef HT_CACHE
+static size_t function(item_bytes)(const HT_ITEM *i)
+{
+	return sizeof(HT_ITEM) + strlen(i->k) + 1 + HT_VALUESIZE(i->v);
+}
+
+// Evicts one item, never the one in bucket keep
+static void function(evict)(HT *ht, int keep)
+{
+	// Sweep the hand over the buckets, anything used since the last sweep
+	// gets a second chance
+	for (;;)
+	{
+		int i = ht->hand;
+		if (++ht->hand == ht->capacity)
+			ht->hand = 0;
+
+		HT_ITEM *it = ht->data[i];
+		if (it == NULL || it == &HT_EMPTY || i == keep)
+			continue;
+		if (ht->ref[i]) {
+			ht->ref[i] = 0;
+			continue; }
+
+		ht->bytes -= function(item_bytes)(it);
+		function(item_free)(ht, it);
+		ht->data[i] = &HT_EMPTY;
+		--ht->count;
+		++ht->deleted;
+		++ht->evictions;
+	#ifdef HT_BLOOM
+		function(bloom_forget)(ht);
+	#endif // HT_BLOOM
+		return;
+	}
+}
+#endif // HT_CACHE
+
 // HASH TABLE FUNCTIONS
 // These are functions you are meant to call
 /* 
@@ -168,82 +567,312 @@ static void function(item_free)(HT_ITEM *i)
 */
 static HT *function(new)()
 {
-	HT *t = malloc(sizeof(HT));
+	HT *t = (HT*)SRXK_MALLOC(SRXK_ALLOC_HT, NULL, sizeof(HT));
 	if (t == NULL) {
 		HT_ERR = ENOMEM;
 		return NULL;}
+	SRXK_ALLOC_OWN(&t->mem, t);
 
 	// Make sure that data is zero'd out
-	t->capacity = 53;
+	t->capacity = HT_START_CAPACITY;
 	t->count = 0;
-	t->data = calloc((size_t)t->capacity, sizeof(HT_ITEM *));
+	t->deleted = 0;
+	t->data = (HT_ITEM**)SRXK_CALLOC(SRXK_ALLOC_HT, &t->mem,
+			(size_t)t->capacity, sizeof(HT_ITEM *));
 	if (t->data == NULL) {
 		HT_ERR = ENOMEM;
+		SRXK_FREE(SRXK_ALLOC_HT, NULL, t);
+		return NULL;}
+#ifdef HT_CACHE
+	t->ref = (unsigned char*)SRXK_CALLOC(SRXK_ALLOC_HT, &t->mem,
+			(size_t)t->capacity, 1);
+	if (t->ref == NULL) {
+		HT_ERR = ENOMEM;
+		SRXK_FREE(SRXK_ALLOC_HT, &t->mem, t->data);
+		SRXK_FREE(SRXK_ALLOC_HT, NULL, t);
+		return NULL;}
+	t->hand = 0;
+	t->max_count = 0;
+	t->max_bytes = 0;
+	t->bytes = 0;
+	t->hits = 0;
+	t->misses = 0;
+	t->evictions = 0;
+#endif // HT_CACHE
+#ifdef HT_BLOOM
+	t->filter = NULL;
+	function(bloom_rebuild)(t);
+	if (t->filter == NULL) {
+		HT_ERR = ENOMEM;
+	#ifdef HT_CACHE
+		SRXK_FREE(SRXK_ALLOC_HT, &t->mem, t->ref);
+	#endif // HT_CACHE
+		SRXK_FREE(SRXK_ALLOC_HT, &t->mem, t->data);
+		SRXK_FREE(SRXK_ALLOC_HT, NULL, t);
 		return NULL;}
+#endif // HT_BLOOM
 	return t;
 }
 
+#ifdef HT_CACHE
 /* 
 * Description:
-* 	Inserts/Updates a  
+* 	Creates a new hash table that evicts items once it is over budget
 * Parameters:
-* 	abc
+* 	int max_count - the most items to keep, 0 for no limit
+* 	size_t max_bytes - the most bytes of items, keys and HT_VALUESIZE to
+* 	keep, 0 for no limit
 * Return Value:
-* 	abc
+* 	Returns an empty heap allocated hash table
+*/
+static HT *function(cache_new)(int max_count, size_t max_bytes)
+{
+	HT *t = function(new)();
+	if (t == NULL)
+		return NULL;
+	t->max_count = max_count;
+	t->max_bytes = max_bytes;
+	return t;
+}
+#endif // HT_CACHE
+
+/* 
+* Description:
+* 	Rehashes every item into a new table of at least capacity buckets, this
+*  also clears out deleted buckets
+* Parameters:
+* 	HT *ht - the hash table to be operated on
+* 	int capacity - the least amount of buckets the new table should have
+* Return Value:
+* 	None, if there is not enough memory the table is left as is
+*/
+static void function(resize)(HT *ht, int capacity)
+{
+	capacity = function(next_prime)(capacity);
+	HT_ITEM **data = (HT_ITEM**)SRXK_CALLOC(SRXK_ALLOC_HT, &ht->mem,
+			(size_t)capacity, sizeof(HT_ITEM *));
+	if (data == NULL) {
+		HT_ERR = ENOMEM;
+		return;}
+#ifdef HT_CACHE
+	unsigned char *ref = (unsigned char*)SRXK_CALLOC(SRXK_ALLOC_HT, &ht->mem,
+			(size_t)capacity, 1);
+	if (ref == NULL) {
+		HT_ERR = ENOMEM;
+		SRXK_FREE(SRXK_ALLOC_HT, &ht->mem, data);
+		return;}
+#endif // HT_CACHE
+
+	// Move the items over, they don't need to be compared as keys are unique
+	for (int i = 0; i < ht->capacity; ++i)
+	{
+		HT_ITEM *it = ht->data[i];
+		if (it == NULL || it == &HT_EMPTY)
+			continue;
+		int step;
+		int index = function(hash)(it->k, capacity, &step);
+		while (data[index] != NULL)
+			index = (index + step) % capacity;
+		data[index] = it;
+#ifdef HT_CACHE
+		ref[index] = ht->ref[i];
+#endif // HT_CACHE
+	}
+
+	SRXK_FREE(SRXK_ALLOC_HT, &ht->mem, ht->data);
+	ht->data = data;
+	ht->capacity = capacity;
+	ht->deleted = 0;
+#ifdef HT_CACHE
+	SRXK_FREE(SRXK_ALLOC_HT, &ht->mem, ht->ref);
+	ht->ref = ref;
+	ht->hand = 0;
+#endif // HT_CACHE
+#ifdef HT_BLOOM
+	function(bloom_rebuild)(ht);
+#endif // HT_BLOOM
+}
+
+/* 
+* Description:
+* 	Inserts a value, or updates it if the key is already in the table. The
+*  table is grown first if it is getting full, with HT_CACHE items are
+*  evicted until the new or updated one fits in the budget
+* Parameters:
+* 	HT *ht - the hash table to be operated on
+* 	const char *key - the key, this is copied
+* 	const HT_TYPE value - the value to store
+* Return Value:
+* 	None, sets HT_ERR to ENOMEM if the item couldn't be allocated or the
+*  table is full and couldn't grow
 */
 static void function(insert)(HT *ht, const char *key, const HT_TYPE value)
 {
-	HT_ITEM *item = function(item_new)(key, value);
-	int index = function(hash)(item->k, ht->capacity, 0);
-	HT_ITEM *cur = ht->data[index];
-	for (int i = 0; cur != NULL && cur != &HT_EMPTY; ++i)
+	if ((long)(ht->count + ht->deleted + 1) * 100
+			> (long)ht->capacity * HT_MAX_LOAD)
+		function(resize)(ht, ht->count * 2 > ht->capacity ? ht->capacity * 2
+				: ht->capacity);
+
+	int step;
+	int index = function(hash)(key, ht->capacity, &step);
+	int tomb = -1;
+	int empty = 0;
+	for (int i = 0; i < ht->capacity; ++i)
 	{
-		if (!strcmp(item->k, key))
-			break;
-		index = function(hash)(item->k, ht->capacity, i);
-		cur = ht->data[index];
+		HT_ITEM *cur = ht->data[index];
+		if (cur == NULL) {
+			empty = 1;
+			break; }
+		if (cur == &HT_EMPTY) {
+			// Remember the first deleted bucket to reuse it
+			if (tomb < 0)
+				tomb = index;
+		} else if (!strcmp(cur->k, key)) {
+			// Update in place
+			#ifdef HT_CACHE
+				// A bigger value can push us over budget too, make room
+				// without evicting the item we are updating
+				size_t old_size = (size_t)HT_VALUESIZE(cur->v);
+				size_t new_size = (size_t)HT_VALUESIZE(value);
+				while (ht->count > 1 && ht->max_bytes && new_size > old_size
+						&& ht->bytes + (new_size - old_size) > ht->max_bytes)
+					function(evict)(ht, index);
+				ht->bytes += new_size - old_size;
+				ht->ref[index] = 1;
+			#endif // HT_CACHE
+			#ifdef HT_FREEVALUE
+				// Storing the same value again mustn't free it
+				if (cur->v != value)
+					free(cur->v);
+			#endif
+			cur->v = value;
+			return;
+		}
+		index = (index + step) % ht->capacity;
 	}
+	// Only possible if the resize above failed, every bucket holds an item
+	if (!empty && tomb < 0) {
+		HT_ERR = ENOMEM;
+		return;}
+
+	HT_ITEM *item = function(item_new)(ht, key, value);
+	if (item == NULL) {
+		HT_ERR = ENOMEM;
+		return;}
+#ifdef HT_CACHE
+	// Make room, evicting only turns items into HT_EMPTY so the bucket we
+	// found is still free
+	size_t bytes = function(item_bytes)(item);
+	while (ht->count > 0 && ((ht->max_count && ht->count >= ht->max_count)
+			|| (ht->max_bytes && ht->bytes + bytes > ht->max_bytes)))
+		function(evict)(ht, -1);
+	ht->bytes += bytes;
+	ht->ref[tomb >= 0 ? tomb : index] = 0;
+#endif // HT_CACHE
+	if (tomb >= 0) {
+		index = tomb;
+		--ht->deleted; }
 	ht->data[index] = item;
 	++ht->count;
+#ifdef HT_BLOOM
+	srxk_bloom_add(ht->filter, item->k);
+#endif // HT_BLOOM
 }
 
+/* 
+* Description:
+* 	Finds the value stored under a key
+* Parameters:
+* 	const HT *ht - the hash table to be operated on
+* 	const char *key - the key to look for
+* Return Value:
+* 	The value, or HT_EMPTYVALUE and sets HT_ERR to ENODATA if it isn't found
+*/
+#ifdef HT_CACHE
+static HT_TYPE function(search)(HT *ht, const char *key)
+#else
 static HT_TYPE function(search)(const HT *ht, const char *key)
+#endif // HT_CACHE
 {
-	int index = function(hash)(key, ht->capacity, 0);
-	HT_ITEM *item = ht->data[index];
-	for (int i = 0; item != NULL; ++i)
+#ifdef HT_BLOOM
+	// Most misses stop here
+	if (!srxk_bloom_test(ht->filter, key)) {
+	#ifdef HT_CACHE
+		++ht->misses;
+	#endif // HT_CACHE
+		HT_ERR = ENODATA;
+		return HT_EMPTYVALUE;}
+#endif // HT_BLOOM
+	int step;
+	int index = function(hash)(key, ht->capacity, &step);
+	for (int i = 0; i < ht->capacity; ++i)
 	{
+		HT_ITEM *item = ht->data[index];
+		if (item == NULL)
+			break;
 		if (item != &HT_EMPTY && !strcmp(item->k, key))
+		{
+		#ifdef HT_CACHE
+			ht->ref[index] = 1;
+			++ht->hits;
+		#endif // HT_CACHE
 			return item->v;
-
-		index = function(hash)(key, ht->capacity, i);
-		item = ht->data[index];
+		}
+		index = (index + step) % ht->capacity;
 	}
 
 	// Not found
+#ifdef HT_CACHE
+	++ht->misses;
+#endif // HT_CACHE
 	HT_ERR = ENODATA;
 	return HT_EMPTYVALUE;
 }
 
+/* 
+* Description:
+* 	Removes a key and its value from the table
+* Parameters:
+* 	HT *ht - the hash table to be operated on
+* 	const char *key - the key to remove
+* Return Value:
+* 	None
+*/
 static void function(delete)(HT *ht, const char *key)
 {
-	int index = function(hash)(key, ht->capacity, 0);
-	HT_ITEM *item = ht->data[index];
-	for (int i = 0; item != NULL; ++i)
+	int step;
+	int index = function(hash)(key, ht->capacity, &step);
+	for (int i = 0; i < ht->capacity; ++i)
 	{
-		if (item != &HT_EMPTY && !strcmp(item->k, key) && (i || !i))
+		HT_ITEM *item = ht->data[index];
+		if (item == NULL)
+			return;
+		if (item != &HT_EMPTY && !strcmp(item->k, key))
 		{
-			function(item_free)(item);
+		#ifdef HT_CACHE
+			ht->bytes -= function(item_bytes)(item);
+		#endif // HT_CACHE
+			function(item_free)(ht, item);
 			ht->data[index] = &HT_EMPTY;
 			--ht->count;
+			++ht->deleted;
+		#ifdef HT_BLOOM
+			function(bloom_forget)(ht);
+		#endif // HT_BLOOM
 			return;
 		}
-		index = function(hash)(key, ht->capacity, i);
-		item = ht->data[index];
+		index = (index + step) % ht->capacity;
 	}
-	
 }
 
+/* 
+* Description:
+* 	Frees every item and the table its self
+* Parameters:
+* 	HT *ht - the hash table to be operated on
+* Return Value:
+* 	None
+*/
 static void function(free)(HT *ht)
 {
 	// Free items
@@ -251,19 +880,51 @@ static void function(free)(HT *ht)
 	{
 		HT_ITEM *it = ht->data[i];
 		if (it != NULL && it->k != NULL)
-			function(item_free)(it);
+			function(item_free)(ht, it);
 	}
 
 	// Free table
-	free(ht->data);
-	free(ht);
+#ifdef HT_CACHE
+	SRXK_FREE(SRXK_ALLOC_HT, &ht->mem, ht->ref);
+#endif // HT_CACHE
+#ifdef HT_BLOOM
+	srxk_bloom_free(ht->filter);
+#endif // HT_BLOOM
+	SRXK_FREE(SRXK_ALLOC_HT, &ht->mem, ht->data);
+	SRXK_FREE(SRXK_ALLOC_HT, NULL, ht);
+}
+
+#ifdef SRXK_TRACK_ALLOC
+/* 
+* Description:
+* 	Gets how many bytes the table has allocated, its self, items, keys and
+*  the bloom filter included. Values aren't counted, even with HT_FREEVALUE
+* Parameters:
+* 	const HT *ht - the hash table to be operated on
+* Return Value:
+* 	The live bytes, ht->mem has the rest of the counts
+*/
+static size_t function(memory_usage)(const HT *ht)
+{
+#ifdef HT_BLOOM
+	if (ht->filter != NULL)
+		return ht->mem.live + srxk_bloom_memory_usage(ht->filter);
+#endif // HT_BLOOM
+	return ht->mem.live;
 }
+#endif // SRXK_TRACK_ALLOC
+#endif // HT_STATIC_CAPACITY
 
 // Undefine the macros to keep things clean
 #undef HT
 #undef HT_TYPE
 #undef HT_ITEM
 #undef HT_FREEVALUE
+#undef HT_CACHE
+#undef HT_VALUESIZE
+#undef HT_BLOOM
+#undef HT_STATIC_CAPACITY
+#undef HT_STATIC_KEYLEN
 #undef HT_EMPTYVALUE
 #undef HT_EMPTY
 #undef HT_ERR
@@ -0,0 +1,312 @@
+/*
+* >> srxk_heap.h 0.1.0
+* A generic C header only d-ary heap implementation
+* The heap lives in a vector from srxk_vector.h, so it uses the vector's
+* storage and growth
+*
+* >> Usage
+* ```
+* #define VECTOR_TYPE int
+* #include <srxk_vector.h>
+*
+* #define HEAP_TYPE int
+* //                ^ the same type as the vector
+* #include <srxk_heap.h>
+* ```
+* If you want to use a pointer or struct you must first typedef it like so:
+* `typedef struct object* objectp;`
+* To have two heaps of the same type, typedef a second name for it
+*
+* `HEAP_ARITY` sets how many children each node has, 4 or 8 keeps all of the
+* children of a node in one or two cache lines. `HEAP_LESS(a, b)` sets the
+* order, the default is a min heap using `<`. If `HEAP_INDEX(x, i)` is
+* defined it is called whenever x moves to index i, store i with x to use
+* `heap_<type>_decrease` and `heap_<type>_remove`
+*
+* If an error ocurrs an integer called `heap_<type>_err` will be set
+*
+* There some examples in `test/` if you need a guide
+*
+* >> License
+* Be Nice Please Public License
+* Version 2, FEBUARY 2020
+*
+* Copyright (C) 2020 Milo Wheeler <milowheeler@protonmail.com>
+*
+* Permission is granted, free of charge, to any person obtaining a copy of this
+* "Software", to the rights to, use, copy, modify, merge, publish, distribute,
+* and/or sell copies of the Software without restriction, this holds true as
+* long as the software is not used to intentionally hurt people, and/or
+* communities emotionally or physically.
+*
+* Due to the nature of Open Source, no liability or warranty of any kind is
+* provided with this Software.
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+// CONSTANTS
+/*These can be tweaked for your needs*/
+#ifndef HEAP_ARITY
+	#define HEAP_ARITY 4
+#endif // HEAP_ARITY
+#ifndef HEAP_LESS
+	#define HEAP_LESS(a, b) ((a) < (b))
+#endif // HEAP_LESS
+#ifndef HEAP_INDEX
+	#define HEAP_INDEX(x, i)
+#endif // HEAP_INDEX
+
+// THE MACRO MAGIC
+#ifndef HEAP_TYPE
+	#define HEAP_TYPE int
+#endif
+
+#define PASTER(x,y) x ## _ ## y
+#define EVALUATOR(x,y)  PASTER(x,y)
+
+#define type(struct,type) EVALUATOR(struct, type)
+#define function(name) EVALUATOR(HEAP, name)
+
+#define HEAP type(heap, HEAP_TYPE)
+#define HEAP_VECTOR type(vec, HEAP_TYPE)
+#define HEAP_VECTOR_FN(name) EVALUATOR(HEAP_VECTOR, name)
+#define HEAP_ERR EVALUATOR(HEAP, err)
+
+// ERROR CODES
+#ifndef ENODATA
+	#define ENODATA 61
+#endif
+
+// ERROR NUMBER
+static int HEAP_ERR = 0;
+
+// SIFT FUNCTIONS
+// You shouldn't be calling these for any good reason
+/*Both of these carry x down a hole instead of swapping, so each level is
+one move*/
+static void function(sift_up)(HEAP_VECTOR *v, int i, HEAP_TYPE x)
+{
+	HEAP_TYPE *a = v->data;
+	while (i > 0)
+	{
+		int p = (i - 1) / HEAP_ARITY;
+		if (!HEAP_LESS(x, a[p]))
+			break;
+		a[i] = a[p];
+		HEAP_INDEX(a[i], i);
+		i = p;
+	}
+	a[i] = x;
+	HEAP_INDEX(a[i], i);
+}
+
+static void function(sift_down)(HEAP_VECTOR *v, int i, HEAP_TYPE x)
+{
+	HEAP_TYPE *a = v->data;
+	const int n = v->len;
+	for (;;)
+	{
+		int c = i * HEAP_ARITY + 1;
+		if (c >= n)
+			break;
+
+		// Find the smallest child, they are all next to each other
+		int end = n - c < HEAP_ARITY ? n : c + HEAP_ARITY;
+		int best = c;
+		for (int j = c + 1; j < end; ++j)
+			if (HEAP_LESS(a[j], a[best]))
+				best = j;
+
+		if (!HEAP_LESS(a[best], x))
+			break;
+		a[i] = a[best];
+		HEAP_INDEX(a[i], i);
+		i = best;
+	}
+	a[i] = x;
+	HEAP_INDEX(a[i], i);
+}
+
+// HEAP FUNCTIONS
+/*
+* Description:
+* 	Turns a vector into a heap in O(n)
+* Parameters:
+* 	HEAP_VECTOR *v - the vector to be operated on
+* Return Value:
+* 	None
+*/
+static void function(heapify)(HEAP_VECTOR *v)
+{
+	// Leaves that never move still need their index recorded
+	for (int i = 0; i < v->len; ++i)
+		HEAP_INDEX(v->data[i], i);
+
+	// Sift down every node that has children, bottom up
+	for (int i = (v->len - 2) / HEAP_ARITY; i >= 0 && v->len > 1; --i)
+		function(sift_down)(v, i, v->data[i]);
+}
+
+/*
+* Description:
+* 	Pushes a new item onto the heap, the vector grows if it needs to
+* Parameters:
+* 	HEAP_VECTOR *v - the vector to be operated on
+* 	HEAP_TYPE x - the item to push
+* Return Value:
+* 	The vector operated on, or NULL if it couldn't grow
+*/
+static HEAP_VECTOR *function(push)(HEAP_VECTOR *v, HEAP_TYPE x)
+{
+	if (HEAP_VECTOR_FN(push)(v, x) == NULL)
+		return NULL;
+	function(sift_up)(v, v->len - 1, x);
+	return v;
+}
+
+/*
+* Description:
+* 	Gets the smallest item without removing it
+* Parameters:
+* 	const HEAP_VECTOR *v - the vector to be operated on
+* Return Value:
+* 	The smallest item, if the heap is empty HEAP_ERR is set to ENODATA
+*/
+static HEAP_TYPE function(top)(const HEAP_VECTOR *v)
+{
+	if (v->len == 0)
+		HEAP_ERR = ENODATA;
+	return v->data[0];
+}
+
+/*
+* Description:
+* 	Removes the smallest item
+* Parameters:
+* 	HEAP_VECTOR *v - the vector to be operated on
+* Return Value:
+* 	The smallest item, if the heap is empty HEAP_ERR is set to ENODATA
+*/
+static HEAP_TYPE function(pop)(HEAP_VECTOR *v)
+{
+	if (v->len == 0) {
+		HEAP_ERR = ENODATA;
+		return v->data[0]; }
+
+	HEAP_TYPE top = v->data[0];
+	HEAP_TYPE last = HEAP_VECTOR_FN(pop)(v);
+	if (v->len > 0)
+		function(sift_down)(v, 0, last);
+	return top;
+}
+
+/*
+* Description:
+* 	Pushes an item then pops the smallest, faster then doing both and
+*  it doesn't touch the heap at all if x would be popped straight away
+* Parameters:
+* 	HEAP_VECTOR *v - the vector to be operated on
+* 	HEAP_TYPE x - the item to push
+* Return Value:
+* 	The smallest out of x and the heap
+*/
+static HEAP_TYPE function(push_pop)(HEAP_VECTOR *v, HEAP_TYPE x)
+{
+	if (v->len == 0 || !HEAP_LESS(v->data[0], x))
+		return x;
+	HEAP_TYPE top = v->data[0];
+	function(sift_down)(v, 0, x);
+	return top;
+}
+
+/*
+* Description:
+* 	Pops the smallest item then pushes x, in one sift down
+* Parameters:
+* 	HEAP_VECTOR *v - the vector to be operated on
+* 	HEAP_TYPE x - the item to push
+* Return Value:
+* 	The smallest item before x was pushed, if the heap is empty x is
+*  returned and HEAP_ERR is set to ENODATA
+*/
+static HEAP_TYPE function(replace_top)(HEAP_VECTOR *v, HEAP_TYPE x)
+{
+	if (v->len == 0) {
+		HEAP_ERR = ENODATA;
+		return x; }
+	HEAP_TYPE top = v->data[0];
+	function(sift_down)(v, 0, x);
+	return top;
+}
+
+/*
+* Description:
+* 	Replaces the item at an index with a smaller one, use HEAP_INDEX to
+*  keep track of where items are
+* Parameters:
+* 	HEAP_VECTOR *v - the vector to be operated on
+* 	int i - the index of the item
+* 	HEAP_TYPE x - the new item, it must not be bigger then the old one
+* Return Value:
+* 	None, if i is out of bounds HEAP_ERR is set to ENODATA
+*/
+static void function(decrease)(HEAP_VECTOR *v, int i, HEAP_TYPE x)
+{
+	if (i < 0 || i >= v->len) {
+		HEAP_ERR = ENODATA;
+		return; }
+	function(sift_up)(v, i, x);
+}
+
+/*
+* Description:
+* 	Removes the item at an index, use HEAP_INDEX to keep track of where
+*  items are
+* Parameters:
+* 	HEAP_VECTOR *v - the vector to be operated on
+* 	int i - the index of the item
+* Return Value:
+* 	The removed item, if i is out of bounds HEAP_ERR is set to ENODATA
+*/
+static HEAP_TYPE function(remove)(HEAP_VECTOR *v, int i)
+{
+	if (i < 0 || i >= v->len) {
+		HEAP_ERR = ENODATA;
+		return v->data[0]; }
+
+	HEAP_TYPE item = v->data[i];
+	HEAP_TYPE last = HEAP_VECTOR_FN(pop)(v);
+	// Put the last item in the hole, it can go either way from there
+	if (i < v->len)
+	{
+		if (HEAP_LESS(last, item))
+			function(sift_up)(v, i, last);
+		else
+			function(sift_down)(v, i, last);
+	}
+	return item;
+}
+
+// Undefine the macros to keep things clean
+#undef HEAP
+#undef HEAP_TYPE
+#undef HEAP_VECTOR
+#undef HEAP_VECTOR_FN
+#undef HEAP_ERR
+#undef HEAP_ARITY
+#undef HEAP_LESS
+#undef HEAP_INDEX
+#undef PASTER
+#undef EVALUATOR
+#undef function
+#undef type
+
+#ifdef __cplusplus
+} // extern "C" closing brace
+#endif	// __cplusplus
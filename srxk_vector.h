@@ -1,5 +1,5 @@
 /*
-* >> srxk_vector.h 0.1.2
+* >> srxk_vector.h 0.3.0
 * A generic C header only vector implementation
 *
 * >> Usage
@@ -14,6 +14,21 @@
 * Custom memory allocators are also supported via by defining CUSTOM_MALLOC,
 * _REALLOC, *_FREE
 * If an error ocurrs an integer called `vec_<type>_err` will be set
+* Define SRXK_TRACK_ALLOC to count the memory vectors use, see srxk_alloc.h
+*
+* Defining `VECTOR_STATIC_CAPACITY N` makes a vector that never allocates, the
+* N elements are stored in the struct so it can live on the stack, in a
+* global or inside another struct. Set it up with `vec_<type>_init(v)`, pushes
+* past N set `vec_<type>_err` to ENOSPC instead of growing. There is no new
+* or free. To have a fixed and a growing vector of one type, typedef a second
+* name for it
+*
+* Defining `VECTOR_ALIGN N` keeps the data aligned to N bytes (a power of two,
+* e.g. 64 for a cache line or an AVX-512 register) across growth, and pads
+* the capacity to whole multiples of N bytes. `vec_<type>_pad(v, x)` fills the
+* rest of the last N bytes with x, so a kernel can run over whole vectors
+* without a scalar tail. Read the data with `vec_<type>_data(v)` into a
+* `SRXK_RESTRICT` pointer so the compiler knows it is aligned and unaliased
 *
 * There some examples in `test/` if you need a guide
 *
@@ -66,6 +81,29 @@ these*/
 #define VECTOR type(vec, VECTOR_TYPE)
 #define VECTOR_ERR EVALUATOR(VECTOR, err)
 
+#ifdef VECTOR_ALIGN
+	#if VECTOR_ALIGN < 1 || (VECTOR_ALIGN & (VECTOR_ALIGN - 1))
+		#error "VECTOR_ALIGN must be a power of two"
+	#endif
+	#ifdef VECTOR_STATIC_CAPACITY
+		#error "VECTOR_ALIGN can't be used with VECTOR_STATIC_CAPACITY"
+	#endif
+	// Rounds a capacity up so it fills whole multiples of VECTOR_ALIGN bytes
+	#define VECTOR_PAD(n) ((int)(SRXK_ALIGN_UP((size_t)(n) \
+			* sizeof(VECTOR_TYPE), VECTOR_ALIGN) / sizeof(VECTOR_TYPE)))
+	#define VECTOR_ALLOC(inst, size) SRXK_ALIGNED_ALLOC(SRXK_ALLOC_VECTOR, \
+			inst, VECTOR_ALIGN, size)
+	#define VECTOR_REALLOC(inst, p, size) SRXK_ALIGNED_REALLOC( \
+			SRXK_ALLOC_VECTOR, inst, p, VECTOR_ALIGN, size)
+	#define VECTOR_FREE(inst, p) SRXK_ALIGNED_FREE(SRXK_ALLOC_VECTOR, inst, p)
+#else
+	#define VECTOR_PAD(n) (n)
+	#define VECTOR_ALLOC(inst, size) SRXK_MALLOC(SRXK_ALLOC_VECTOR, inst, size)
+	#define VECTOR_REALLOC(inst, p, size) SRXK_REALLOC(SRXK_ALLOC_VECTOR, \
+			inst, p, size)
+	#define VECTOR_FREE(inst, p) SRXK_FREE(SRXK_ALLOC_VECTOR, inst, p)
+#endif // VECTOR_ALIGN
+
 // CUSTOM MEMORY MANAGER
 #ifdef CUSTOM_MALLOC
 	// Make sure that realloc and free are also defined
@@ -77,27 +115,91 @@ these*/
 	#define realloc CUSTOM_REALLOC
 	#define free CUSTOM_FREE
 #endif
+#include "srxk_alloc.h"
 
 // ERROR CODES
 #ifndef ENOMEM
 	#define ENOMEM 12
 #endif
+#ifndef ENOSPC
+	#define ENOSPC 28
+#endif
 #ifndef ENODATA
 	#define ENODATA 61
 #endif
 
 // VECTOR TYPE
+#ifdef VECTOR_STATIC_CAPACITY
+typedef struct VECTOR
+{
+	VECTOR_TYPE data[VECTOR_STATIC_CAPACITY];
+	int capacity;
+	int len;
+} VECTOR;
+#else
 typedef struct VECTOR
 {
 	VECTOR_TYPE *data;
 	int capacity;
 	int len;
+#ifdef SRXK_TRACK_ALLOC
+	srxk_alloc_stats mem;
+#endif // SRXK_TRACK_ALLOC
 } VECTOR;
+#endif // VECTOR_STATIC_CAPACITY
 
 // ERROR NUMBER
 static int VECTOR_ERR = 0;
 
 // VECTOR FUNCTIONS
+#ifdef VECTOR_STATIC_CAPACITY
+/* 
+* Description:
+* 	Sets up a fixed vector, the elements aren't touched so this is O(1)
+* Parameters:
+* 	VECTOR *v - the vector to be operated on
+* Return Value:
+* 	The vector operated on
+*/
+static VECTOR *function(init)(VECTOR *v)
+{
+	v->capacity = VECTOR_STATIC_CAPACITY;
+	v->len = 0;
+	return v;
+}
+
+/* 
+* Description:
+* 	Empties a fixed vector in O(1) so it can be reused
+* Parameters:
+* 	VECTOR *v - the vector to be operated on
+* Return Value:
+* 	None
+*/
+static void function(reset)(VECTOR *v)
+{
+	v->len = 0;
+}
+
+/* 
+* Description:
+* 	Adds a new item to the vector if there is room
+* Parameters:
+* 	VECTOR *v - the vector to be operated on
+	VECTOR_TYPE data - the data to be pushed onto
+* Return Value:
+* 	The vector operated on, or NULL and sets VECTOR_ERR to ENOSPC if it is
+* 	full
+*/
+static VECTOR *function(push)(VECTOR *v, VECTOR_TYPE data)
+{
+	if (v->len == VECTOR_STATIC_CAPACITY) {
+		VECTOR_ERR = ENOSPC;
+		return NULL;}
+	v->data[v->len++] = data;
+	return v;
+}
+#else
 /* 
 * Description:
 * 	Create's a new vector
@@ -110,14 +212,16 @@ static VECTOR *function(new)()
 {
 	// Create our vector
 	VECTOR *t;
-	t = (VECTOR*)malloc(sizeof(VECTOR));
+	t = (VECTOR*)SRXK_MALLOC(SRXK_ALLOC_VECTOR, NULL, sizeof(VECTOR));
 	if (t == NULL) { // If failed set errno and return NULL
 		VECTOR_ERR = ENOMEM;
 		return NULL;}
+	SRXK_ALLOC_OWN(&t->mem, t);
 
 	// Malloc the data and set limits
-	t->data = (VECTOR_TYPE*)malloc(sizeof(VECTOR_TYPE) * VECTOR_START_LENGTH);
-	t->capacity = VECTOR_START_LENGTH;
+	t->capacity = VECTOR_PAD(VECTOR_START_LENGTH);
+	t->data = (VECTOR_TYPE*)VECTOR_ALLOC(&t->mem, sizeof(VECTOR_TYPE)
+			* t->capacity);
 	t->len = 0;
 
 	if (t->data == NULL) { // If failed set errno and return NULL
@@ -150,11 +254,12 @@ static VECTOR *function(push)(VECTOR *v, VECTOR_TYPE data)
 		// Other wise just our factor
 		else
 			v->capacity = newsize;
+		v->capacity = VECTOR_PAD(v->capacity);
 
 		// Resize our data section
 		VECTOR t;
-		t.data = (VECTOR_TYPE*)realloc(v->data, sizeof(VECTOR_TYPE) *
-		                                                  v->capacity);
+		t.data = (VECTOR_TYPE*)VECTOR_REALLOC(&v->mem, v->data,
+				sizeof(VECTOR_TYPE) * v->capacity);
 		if (t.data == NULL) { // If failed set errno and return NULL
 			VECTOR_ERR = ENOMEM;
 			return NULL;}
@@ -167,6 +272,7 @@ static VECTOR *function(push)(VECTOR *v, VECTOR_TYPE data)
 	// Return vector for convenience
 	return v;
 }
+#endif // VECTOR_STATIC_CAPACITY
 
 /* 
 * Description:
@@ -205,6 +311,46 @@ static VECTOR_TYPE function(last)(const VECTOR *v)
 		return v->data[v->len - 1];
 }
 
+/* 
+* Description:
+* 	Gets the data for a kernel to work on, with VECTOR_ALIGN the compiler
+*  is told that it is aligned. Store it in a `VECTOR_TYPE *SRXK_RESTRICT`
+*  if nothing else is written while it is used
+* Parameters:
+* 	VECTOR *v - the vector to be operated on
+* Return Value:
+* 	A pointer to the first item
+*/
+static VECTOR_TYPE *function(data)(VECTOR *v)
+{
+#ifdef VECTOR_ALIGN
+	return (VECTOR_TYPE*)SRXK_ASSUME_ALIGNED(v->data, VECTOR_ALIGN);
+#else
+	return v->data;
+#endif // VECTOR_ALIGN
+}
+
+#ifdef VECTOR_ALIGN
+/* 
+* Description:
+* 	Fills the space after the last item up to the next multiple of
+*  VECTOR_ALIGN bytes, the items stay where they are and len isn't changed
+* Parameters:
+* 	VECTOR *v - the vector to be operated on
+* 	VECTOR_TYPE x - what to fill with, e.g. 0 for a sum
+* Return Value:
+* 	The padded length, a kernel can read this many items
+*/
+static int function(pad)(VECTOR *v, VECTOR_TYPE x)
+{
+	int n = VECTOR_PAD(v->len);
+	for (int i = v->len; i < n; ++i)
+		v->data[i] = x;
+	return n;
+}
+#endif // VECTOR_ALIGN
+
+#ifndef VECTOR_STATIC_CAPACITY
 /* 
 * Description:
 * 	Frees a vectors data and its self
@@ -215,13 +361,35 @@ static VECTOR_TYPE function(last)(const VECTOR *v)
 */
 static void function(free)(VECTOR *v)
 {
-	free(v->data);
-	free(v);
+	VECTOR_FREE(&v->mem, v->data);
+	SRXK_FREE(SRXK_ALLOC_VECTOR, NULL, v);
+}
+
+#ifdef SRXK_TRACK_ALLOC
+/* 
+* Description:
+* 	Gets how many bytes the vector has allocated, its self included
+* Parameters:
+* 	const VECTOR *v - the vector to be operated on
+* Return Value:
+* 	The live bytes, v->mem has the rest of the counts
+*/
+static size_t function(memory_usage)(const VECTOR *v)
+{
+	return v->mem.live;
 }
+#endif // SRXK_TRACK_ALLOC
+#endif // VECTOR_STATIC_CAPACITY
 
 // Undefine the macros to keep things clean
 #undef VECTOR
 #undef VECTOR_TYPE
+#undef VECTOR_STATIC_CAPACITY
+#undef VECTOR_ALIGN
+#undef VECTOR_PAD
+#undef VECTOR_ALLOC
+#undef VECTOR_REALLOC
+#undef VECTOR_FREE
 #undef VECTOR_ERR
 #undef PASTER
 #undef EVALUATOR
@@ -0,0 +1,519 @@
+// Benchmarks for the srxk headers
+// Results are written to stdout as CSV, one row per container, operation,
+// size and key length, so runs from different commits can be diffed
+// usage: ./benchmark [max size]
+
+// This creates a vector type of int
+#define VECTOR_TYPE int
+#include <srxk_vector.h>
+
+// These create a plain and a 64 byte aligned vector of float
+#define VECTOR_TYPE float
+#include <srxk_vector.h>
+typedef float afloat;
+#define VECTOR_TYPE afloat
+#define VECTOR_ALIGN 64
+#include <srxk_vector.h>
+
+// This creates a hash table of char*
+typedef char* string;
+#define HT_TYPE string
+#define HT_EMPTYVALUE NULL
+#include <srxk_hashtable.h>
+
+// This creates a bounded cache of char*
+typedef char* cstring;
+#define HT_TYPE cstring
+#define HT_EMPTYVALUE NULL
+#define HT_CACHE
+#include <srxk_hashtable.h>
+
+// This creates a hash table of char* with a bloom filter for misses
+typedef char* fstring;
+#define HT_TYPE fstring
+#define HT_EMPTYVALUE NULL
+#define HT_BLOOM
+#include <srxk_hashtable.h>
+
+// This creates a fixed hash table of char* that is reset per request
+typedef char* sstring;
+#define HT_TYPE sstring
+#define HT_EMPTYVALUE NULL
+#define HT_STATIC_CAPACITY 128
+#include <srxk_hashtable.h>
+
+#define GAPBUFFER_TYPE char
+#include <srxk_gapbuffer.h>
+
+#define DEQUE_TYPE int
+#include <srxk_deque.h>
+
+// These create binary, 4-ary and 8-ary heaps of int
+typedef int heap2_t;
+#define VECTOR_TYPE heap2_t
+#include <srxk_vector.h>
+#define HEAP_TYPE heap2_t
+#define HEAP_ARITY 2
+#include <srxk_heap.h>
+typedef int heap4_t;
+#define VECTOR_TYPE heap4_t
+#include <srxk_vector.h>
+#define HEAP_TYPE heap4_t
+#define HEAP_ARITY 4
+#include <srxk_heap.h>
+typedef int heap8_t;
+#define VECTOR_TYPE heap8_t
+#include <srxk_vector.h>
+#define HEAP_TYPE heap8_t
+#define HEAP_ARITY 8
+#include <srxk_heap.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+
+// How many operations are timed together as one sample
+#define BATCH 256
+// Skip key sets bigger then this many bytes
+#define MAX_KEY_BYTES (512L << 20)
+
+// BENCHMARK HELPERS
+typedef struct bench
+{
+	double *samples; // ns per op of each batch
+	long count;
+	long cap;
+	double total; // ns
+	long ops;
+	double hit_pct; // Only printed if it is set
+} bench;
+
+static double now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static unsigned long long rng_state = 0x9e3779b97f4a7c15ULL;
+static unsigned long long rng(void)
+{
+	// xorshift64*
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return rng_state * 0x2545f4914f6cdd1dULL;
+}
+
+static void bench_start(bench *b)
+{
+	b->count = 0;
+	b->total = 0;
+	b->ops = 0;
+	b->hit_pct = -1;
+}
+
+static void bench_sample(bench *b, double ns, long ops)
+{
+	if (b->count == b->cap)
+	{
+		b->cap = b->cap ? b->cap * 2 : 1024;
+		b->samples = realloc(b->samples, sizeof(double) * b->cap);
+	}
+	b->samples[b->count++] = ns / ops;
+	b->total += ns;
+	b->ops += ops;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+	double x = *(const double*)a, y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+static void bench_report(bench *b, const char *container, const char *op,
+		long size, int key_len)
+{
+	if (b->count == 0)
+		return;
+	qsort(b->samples, b->count, sizeof(double), cmp_double);
+	printf("%s,%s,%ld,%d,%ld,%.0f,%.2f,%.2f,%.2f,", container, op, size,
+			key_len, b->ops, b->ops / (b->total / 1e9),
+			b->samples[b->count / 2], b->samples[b->count * 9 / 10],
+			b->samples[b->count * 99 / 100]);
+	if (b->hit_pct >= 0)
+		printf("%.2f", b->hit_pct);
+	printf("\n");
+}
+
+/*Runs body once for every i in [0, n) timing it in batches*/
+#define TIMED(b, n, body) do { \
+	bench_start(b); \
+	for (long _s = 0; _s < (n); _s += BATCH) { \
+		long _e = _s + BATCH < (n) ? _s + BATCH : (n); \
+		double _t = now_ns(); \
+		for (long i = _s; i < _e; ++i) { body; } \
+		bench_sample(b, now_ns() - _t, _e - _s); \
+	} } while (0)
+
+// Stops the compiler throwing away results
+static volatile long sink;
+
+// VECTOR
+static void bench_vector(bench *b, long n)
+{
+	vec_int *v = vec_int_new();
+	TIMED(b, n, vec_int_push(v, (int)i));
+	bench_report(b, "vector", "push", n, 0);
+	long sum = 0;
+	TIMED(b, n, sum += vec_int_pop(v));
+	bench_report(b, "vector", "pop", n, 0);
+	sink = sum;
+	vec_int_free(v);
+}
+
+// REDUCTION
+#if defined(__GNUC__) || defined(__clang__)
+/*Sums with 256 bit vectors, two at a time. The plain vector is only 16 byte
+aligned so it needs unaligned loads, which split cache lines, and a scalar
+tail. The aligned one is padded with zeros so it never has a tail*/
+typedef float v8f __attribute__((vector_size(32)));
+
+static float sum_v8f(v8f a)
+{
+	float s = 0;
+	for (int j = 0; j < 8; ++j)
+		s += a[j];
+	return s;
+}
+
+static float sum_plain(const float *SRXK_RESTRICT d, int n)
+{
+	v8f a = {0}, b = {0};
+	int i = 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		v8f x, y;
+		memcpy(&x, d + i, sizeof(x));
+		memcpy(&y, d + i + 8, sizeof(y));
+		a += x;
+		b += y;
+	}
+	float s = sum_v8f(a + b);
+	for (; i < n; ++i)
+		s += d[i];
+	return s;
+}
+
+static float sum_aligned(const afloat *SRXK_RESTRICT d, int n)
+{
+	v8f a = {0}, b = {0};
+	for (int i = 0; i < n; i += 16)
+	{
+		a += *(const v8f*)(d + i);
+		b += *(const v8f*)(d + i + 8);
+	}
+	return sum_v8f(a + b);
+}
+
+/*One op is a sum over the whole vector*/
+static void bench_reduce(bench *b, long n)
+{
+	vec_float *v = vec_float_new();
+	vec_afloat *av = vec_afloat_new();
+	for (long i = 0; i < n; ++i)
+	{
+		vec_float_push(v, (float)(i & 7));
+		vec_afloat_push(av, (float)(i & 7));
+	}
+	int padded = vec_afloat_pad(av, 0.0f);
+	long reps = 100000000L / n;
+	reps = reps < 10 ? 10 : reps;
+
+	float sum = 0;
+	TIMED(b, reps, sum += sum_plain(vec_float_data(v), v->len));
+	bench_report(b, "vector_float", "sum", n, 0);
+	TIMED(b, reps, sum += sum_aligned(vec_afloat_data(av), padded));
+	bench_report(b, "vector_float_align64", "sum", n, 0);
+	sink = (long)sum;
+	vec_float_free(v);
+	vec_afloat_free(av);
+}
+#endif
+
+// DEQUE
+static void bench_deque(bench *b, long n)
+{
+	deque_int *d = deque_int_new();
+	TIMED(b, n, deque_int_push_back(d, (int)i));
+	bench_report(b, "deque", "push_back", n, 0);
+	long sum = 0;
+	TIMED(b, n, sum += *deque_int_at(d, (int)(rng() % n)));
+	bench_report(b, "deque", "at", n, 0);
+	TIMED(b, n, sum += deque_int_pop_front(d));
+	bench_report(b, "deque", "pop_front", n, 0);
+	sink = sum;
+	deque_int_free(d);
+}
+
+// HEAP
+/*Pushes n random items, replays n push_pops against the full heap then pops
+them all, for each arity*/
+#define BENCH_HEAP(t, name) \
+static void bench_##t(bench *b, long n) \
+{ \
+	vec_##t *v = vec_##t##_new(); \
+	long sum = 0; \
+	TIMED(b, n, heap_##t##_push(v, (int)(rng() >> 33))); \
+	bench_report(b, name, "push", n, 0); \
+	TIMED(b, n, sum += heap_##t##_push_pop(v, (int)(rng() >> 33))); \
+	bench_report(b, name, "push_pop", n, 0); \
+	TIMED(b, n, sum += heap_##t##_pop(v)); \
+	bench_report(b, name, "pop", n, 0); \
+	sink = sum; \
+	vec_##t##_free(v); \
+}
+BENCH_HEAP(heap2_t, "heap2")
+BENCH_HEAP(heap4_t, "heap4")
+BENCH_HEAP(heap8_t, "heap8")
+
+// HASH TABLE
+/*Fills keys with n null terminated keys of key_len characters, each one
+unique, prefix is the first character so hit and miss sets never overlap*/
+static char *make_keys(long n, int key_len, char prefix)
+{
+	char *keys = malloc((size_t)n * (key_len + 1));
+	if (keys == NULL)
+		return NULL;
+	for (long i = 0; i < n; ++i)
+	{
+		char *k = keys + i * (key_len + 1);
+		memset(k, 'k', key_len);
+		k[0] = prefix;
+		// Spread the index over the key so they don't share a long prefix
+		unsigned long x = (unsigned long)i;
+		for (int j = 1; j < key_len && x; ++j, x >>= 4)
+			k[j] = "0123456789abcdef"[x & 15];
+		k[key_len] = '\0';
+	}
+	return keys;
+}
+
+static void bench_hashtable(bench *b, long n, int key_len)
+{
+	if (n * (key_len + 1) * 2 > MAX_KEY_BYTES)
+		return;
+	char *hit = make_keys(n, key_len, 'h');
+	char *miss = make_keys(n, key_len, 'm');
+	if (hit == NULL || miss == NULL) {
+		free(hit);
+		free(miss);
+		return; }
+	const int stride = key_len + 1;
+
+	ht_string *ht = ht_string_new();
+	TIMED(b, n, ht_string_insert(ht, hit + i * stride, hit));
+	bench_report(b, "hashtable", "insert", n, key_len);
+
+	long found = 0;
+	TIMED(b, n, found += ht_string_search(ht, hit + i * stride) != NULL);
+	bench_report(b, "hashtable", "search_hit", n, key_len);
+	TIMED(b, n, found += ht_string_search(ht, miss + i * stride) != NULL);
+	bench_report(b, "hashtable", "search_miss", n, key_len);
+	sink = found;
+
+	TIMED(b, n, ht_string_delete(ht, hit + i * stride));
+	bench_report(b, "hashtable", "delete", n, key_len);
+	ht_string_free(ht);
+
+	// Again with the bloom filter
+	ht_fstring *hf = ht_fstring_new();
+	TIMED(b, n, ht_fstring_insert(hf, hit + i * stride, hit));
+	bench_report(b, "hashtable_bloom", "insert", n, key_len);
+	TIMED(b, n, found += ht_fstring_search(hf, hit + i * stride) != NULL);
+	bench_report(b, "hashtable_bloom", "search_hit", n, key_len);
+	TIMED(b, n, found += ht_fstring_search(hf, miss + i * stride) != NULL);
+	bench_report(b, "hashtable_bloom", "search_miss", n, key_len);
+	sink = found;
+	TIMED(b, n, ht_fstring_delete(hf, hit + i * stride));
+	bench_report(b, "hashtable_bloom", "delete", n, key_len);
+	ht_fstring_free(hf);
+
+	free(hit);
+	free(miss);
+}
+
+// REQUEST
+/*Each request fills a table with 64 keys, looks them all up and throws the
+table away, a growing table is made and freed while a fixed one is reset*/
+static void bench_request(bench *b)
+{
+	const int key_len = 16;
+	const int stride = key_len + 1;
+	const int per = 64;
+	const long reqs = 100000;
+	char *keys = make_keys(1024, key_len, 'r');
+	if (keys == NULL)
+		return;
+	long found = 0;
+
+	TIMED(b, reqs, {
+		char *k = keys + (i * per % 1024) * stride;
+		ht_string *ht = ht_string_new();
+		for (int j = 0; j < per; ++j)
+			ht_string_insert(ht, k + j * stride, k);
+		for (int j = 0; j < per; ++j)
+			found += ht_string_search(ht, k + j * stride) != NULL;
+		ht_string_free(ht);
+	});
+	bench_report(b, "hashtable", "request", per, key_len);
+
+	static ht_sstring fixed;
+	ht_sstring_init(&fixed);
+	TIMED(b, reqs, {
+		char *k = keys + (i * per % 1024) * stride;
+		for (int j = 0; j < per; ++j)
+			ht_sstring_insert(&fixed, k + j * stride, k);
+		for (int j = 0; j < per; ++j)
+			found += ht_sstring_search(&fixed, k + j * stride) != NULL;
+		ht_sstring_reset(&fixed);
+	});
+	bench_report(b, "hashtable_static", "request", per, key_len);
+	sink = found;
+	free(keys);
+}
+
+// CACHE
+/*Replays a Zipfian trace over n keys through a cache that holds a tenth of
+them, misses are inserted like a memoization cache would*/
+static void bench_cache(bench *b, long n)
+{
+	const int key_len = 16;
+	const int stride = key_len + 1;
+	const long ops = 2000000;
+	if (n * stride > MAX_KEY_BYTES)
+		return;
+
+	char *keys = make_keys(n, key_len, 'z');
+	double *cdf = malloc(sizeof(double) * n);
+	long *trace = malloc(sizeof(long) * ops);
+	if (keys == NULL || cdf == NULL || trace == NULL) {
+		free(keys);
+		free(cdf);
+		free(trace);
+		return; }
+
+	// Build the trace up front so sampling isn't timed
+	double sum = 0;
+	for (long i = 0; i < n; ++i)
+		cdf[i] = sum += 1.0 / pow((double)(i + 1), 0.99);
+	for (long i = 0; i < ops; ++i)
+	{
+		double u = (rng() >> 11) * (1.0 / 9007199254740992.0) * sum;
+		long lo = 0, hi = n - 1;
+		while (lo < hi)
+		{
+			long mid = (lo + hi) / 2;
+			if (cdf[mid] < u)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		trace[i] = lo;
+	}
+
+	int budget = n / 10 > 10 ? (int)(n / 10) : 10;
+	ht_cstring *c = ht_cstring_cache_new(budget, 0);
+	TIMED(b, ops, {
+		char *k = keys + trace[i] * stride;
+		if (ht_cstring_search(c, k) == NULL)
+			ht_cstring_insert(c, k, k);
+	});
+	b->hit_pct = 100.0 * c->hits / (c->hits + c->misses);
+	bench_report(b, "cache", "zipf_0.99", n, key_len);
+
+	ht_cstring_free(c);
+	free(keys);
+	free(cdf);
+	free(trace);
+}
+
+// GAP BUFFER
+static void bench_gapbuffer(bench *b, long n)
+{
+	gb_char *gb = gb_char_new(16);
+	TIMED(b, n, gb_char_insert(gb, 'a' + (char)(i % 26)));
+	bench_report(b, "gapbuffer", "insert", n, 0);
+
+	// Every move is a memmove of the distance, so do less of them as the
+	// buffer gets bigger
+	long moves = 100000000L / n;
+	moves = moves < 100 ? 100 : moves > 100000 ? 100000 : moves;
+	TIMED(b, moves, gb_char_move(gb, (int)(rng() % (n + 1))));
+	bench_report(b, "gapbuffer", "move", n, 0);
+
+	// A find and replace over the buffer, one op is one edit. Done with the
+	// cursor the gap goes back and forth, apply_edits does it in one pass
+	int edits = (int)(n / 64 < 4096 ? n / 64 : 4096);
+	if (edits > 0)
+	{
+		gb_char_edit *e = malloc(sizeof(gb_char_edit) * edits);
+		for (int k = 0; k < edits; ++k)
+		{
+			e[k].pos = (int)(n / edits * k);
+			e[k].del = 3;
+			e[k].data = "XYZ";
+			e[k].len = 3;
+		}
+		TIMED(b, edits, {
+			int k = (int)(rng() % edits);
+			gb_char_move(gb, e[k].pos + 3);
+			gb_char_deletes(gb, 3);
+			gb_char_inserts(gb, "XYZ", 3); });
+		bench_report(b, "gapbuffer", "edit", n, 0);
+
+		long batches = 100000000L / n;
+		batches = batches < 10 ? 10 : batches > 1000 ? 1000 : batches;
+		bench_start(b);
+		for (long r = 0; r < batches; ++r)
+		{
+			double t = now_ns();
+			gb_char_apply_edits(gb, e, edits);
+			bench_sample(b, now_ns() - t, edits);
+		}
+		bench_report(b, "gapbuffer", "apply_edits", n, 0);
+		free(e);
+	}
+	gb_char_free(gb);
+}
+
+int main(int argc, char **argv)
+{
+	long max = argc > 1 ? atol(argv[1]) : 10000000L;
+	static const int key_lens[] = {8, 16, 64};
+	bench b = {0};
+
+	printf("container,op,size,key_len,ops,ops_per_sec,ns_p50,ns_p90,ns_p99,"
+			"hit_pct\n");
+	bench_request(&b);
+	for (long n = 100; n <= max; n *= 10)
+	{
+		bench_vector(&b, n);
+	#if defined(__GNUC__) || defined(__clang__)
+		bench_reduce(&b, n);
+	#endif
+		bench_deque(&b, n);
+		if (n >= 1000) {
+			bench_heap2_t(&b, n);
+			bench_heap4_t(&b, n);
+			bench_heap8_t(&b, n); }
+		for (size_t k = 0; k < sizeof(key_lens) / sizeof(*key_lens); ++k)
+			bench_hashtable(&b, n, key_lens[k]);
+		bench_cache(&b, n);
+		bench_gapbuffer(&b, n);
+		fflush(stdout);
+	}
+
+	free(b.samples);
+	return 0;
+}
@@ -0,0 +1,193 @@
+// Benchmarks for srxk.hpp against the standard library containers
+// The CSV has the same columns as ./benchmark so the two can be joined
+// usage: ./benchmark_cpp [max size]
+#include <srxk.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// How many operations are timed together as one sample
+#define BATCH 256
+// Skip key sets bigger then this many bytes
+#define MAX_KEY_BYTES (512L << 20)
+
+// BENCHMARK HELPERS
+struct bench
+{
+	std::vector<double> samples; // ns per op of each batch
+	double total = 0; // ns
+	long ops = 0;
+};
+
+static double now_ns()
+{
+	using namespace std::chrono;
+	return (double)duration_cast<nanoseconds>(
+			steady_clock::now().time_since_epoch()).count();
+}
+
+static unsigned long long rng_state = 0x9e3779b97f4a7c15ULL;
+static unsigned long long rng()
+{
+	// xorshift64*
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return rng_state * 0x2545f4914f6cdd1dULL;
+}
+
+/*Runs body once for every i in [0, n) timing it in batches*/
+template <class F>
+static void timed(bench &b, long n, F body)
+{
+	b.samples.clear();
+	b.total = 0;
+	b.ops = 0;
+	for (long s = 0; s < n; s += BATCH)
+	{
+		long e = std::min(s + BATCH, n);
+		double t = now_ns();
+		for (long i = s; i < e; ++i)
+			body(i);
+		t = now_ns() - t;
+		b.samples.push_back(t / (e - s));
+		b.total += t;
+		b.ops += e - s;
+	}
+}
+
+static void report(bench &b, const char *container, const char *op,
+		long size, int key_len)
+{
+	if (b.samples.empty())
+		return;
+	std::vector<double> &s = b.samples;
+	std::sort(s.begin(), s.end());
+	std::printf("%s,%s,%ld,%d,%ld,%.0f,%.2f,%.2f,%.2f,\n", container, op, size,
+			key_len, b.ops, b.ops / (b.total / 1e9), s[s.size() / 2],
+			s[s.size() * 9 / 10], s[s.size() * 99 / 100]);
+}
+
+// Stops the compiler throwing away results
+static volatile long sink;
+
+// VECTOR
+/*Pushes n ints then n short strings, which take the memcpy and move paths*/
+template <class Vector>
+static void bench_vector(bench &b, long n, const char *name)
+{
+	Vector v;
+	timed(b, n, [&](long i) { v.push_back((int)i); });
+	report(b, name, "push_int", n, 0);
+
+	std::string container = std::string(name) + "_string";
+	typename Vector::template rebind<std::string> sv;
+	timed(b, n, [&](long i) { sv.emplace_back(16, (char)('a' + i % 26)); });
+	report(b, container.c_str(), "emplace_back", n, 16);
+	long sum = 0;
+	timed(b, n, [&](long i) { sum += sv[(std::size_t)i].size(); });
+	report(b, container.c_str(), "index", n, 16);
+	sink = sum;
+}
+
+template <class T>
+struct srxk_vector : srxk::vector<T>
+{
+	template <class U> using rebind = srxk_vector<U>;
+};
+template <class T>
+struct std_vector : std::vector<T>
+{
+	template <class U> using rebind = std_vector<U>;
+};
+
+// HASH TABLE
+/*Same keys as ./benchmark, stored as std::string and looked up through a
+string_view into a shared buffer, which std::unordered_map has to copy into a
+std::string first*/
+static std::vector<char> make_keys(long n, int key_len, char prefix)
+{
+	std::vector<char> keys((std::size_t)n * key_len, 'k');
+	for (long i = 0; i < n; ++i)
+	{
+		char *k = keys.data() + i * key_len;
+		k[0] = prefix;
+		unsigned long x = (unsigned long)i;
+		for (int j = 1; j < key_len && x; ++j, x >>= 4)
+			k[j] = "0123456789abcdef"[x & 15];
+	}
+	return keys;
+}
+
+static void bench_hashtable(bench &b, long n, int key_len)
+{
+	if (n * key_len * 2 > MAX_KEY_BYTES)
+		return;
+	std::vector<char> hit = make_keys(n, key_len, 'h');
+	std::vector<char> miss = make_keys(n, key_len, 'm');
+	auto key = [&](std::vector<char> &k, long i) {
+		return std::string_view(k.data() + i * key_len, key_len); };
+	long found = 0;
+
+	srxk::hashtable<std::string, long> ht;
+	timed(b, n, [&](long i) { ht.try_emplace(key(hit, i), i); });
+	report(b, "cpp_hashtable", "insert", n, key_len);
+	timed(b, n, [&](long i) { found += ht.find(key(hit, i)) != nullptr; });
+	report(b, "cpp_hashtable", "search_hit", n, key_len);
+	timed(b, n, [&](long i) { found += ht.find(key(miss, i)) != nullptr; });
+	report(b, "cpp_hashtable", "search_miss", n, key_len);
+	timed(b, n, [&](long i) { ht.erase(key(hit, i)); });
+	report(b, "cpp_hashtable", "delete", n, key_len);
+
+	std::unordered_map<std::string, long> um;
+	timed(b, n, [&](long i) { um.try_emplace(std::string(key(hit, i)), i); });
+	report(b, "std_unordered_map", "insert", n, key_len);
+	timed(b, n, [&](long i) {
+		found += um.find(std::string(key(hit, i))) != um.end(); });
+	report(b, "std_unordered_map", "search_hit", n, key_len);
+	timed(b, n, [&](long i) {
+		found += um.find(std::string(key(miss, i))) != um.end(); });
+	report(b, "std_unordered_map", "search_miss", n, key_len);
+	timed(b, n, [&](long i) { um.erase(std::string(key(hit, i))); });
+	report(b, "std_unordered_map", "delete", n, key_len);
+	sink = found;
+}
+
+// GAP BUFFER
+static void bench_gapbuffer(bench &b, long n)
+{
+	srxk::gapbuffer<char> gb(16);
+	timed(b, n, [&](long i) { gb.insert((char)('a' + i % 26)); });
+	report(b, "cpp_gapbuffer", "insert", n, 0);
+
+	long moves = 100000000L / n;
+	moves = moves < 100 ? 100 : moves > 100000 ? 100000 : moves;
+	timed(b, moves, [&](long) { gb.move((std::size_t)(rng() % (n + 1))); });
+	report(b, "cpp_gapbuffer", "move", n, 0);
+}
+
+int main(int argc, char **argv)
+{
+	long max = argc > 1 ? std::atol(argv[1]) : 10000000L;
+	static const int key_lens[] = {8, 16, 64};
+	bench b;
+
+	std::printf("container,op,size,key_len,ops,ops_per_sec,ns_p50,ns_p90,"
+			"ns_p99,hit_pct\n");
+	for (long n = 100; n <= max; n *= 10)
+	{
+		bench_vector<srxk_vector<int>>(b, n, "cpp_vector");
+		bench_vector<std_vector<int>>(b, n, "std_vector");
+		for (int k : key_lens)
+			bench_hashtable(b, n, k);
+		bench_gapbuffer(b, n);
+		std::fflush(stdout);
+	}
+	return 0;
+}
@@ -3,6 +3,22 @@
 #include <srxk_vector.h>
 
 
+// This creates a 4-ary min heap on top of vec_int
+#define HEAP_TYPE int
+#include <srxk_heap.h>
+
+
+// This creates a heap of task pointers that keeps each task's index up to
+// date, so tasks can be found again to decrease or remove
+typedef struct task { int key; int idx; } *task_ptr;
+#define VECTOR_TYPE task_ptr
+#include <srxk_vector.h>
+#define HEAP_TYPE task_ptr
+#define HEAP_LESS(a, b) ((a)->key < (b)->key)
+#define HEAP_INDEX(x, i) ((x)->idx = (i))
+#include <srxk_heap.h>
+
+
 // This creates a vector type of char*
 typedef char* string;
 #define VECTOR_TYPE string
@@ -23,14 +39,70 @@ typedef struct mystruct* mystruct_ptr;
 #define HT_EMPTYVALUE NULL
 #include <srxk_hashtable.h>
 
+// This creates a hash table that frees its values
+typedef char* owned;
+#define HT_TYPE owned
+#define HT_EMPTYVALUE NULL
+#define HT_FREEVALUE
+#include <srxk_hashtable.h>
+
+// This creates a hash table of int that evicts once it is full, each value
+// counts as that many bytes
+#define HT_TYPE int
+#define HT_EMPTYVALUE 0
+#define HT_CACHE
+#define HT_VALUESIZE(v) ((size_t)(v))
+#include <srxk_hashtable.h>
+
+// This creates a hash table of double with a bloom filter in front of it
+#define HT_TYPE double
+#define HT_EMPTYVALUE 0.0
+#define HT_BLOOM
+#include <srxk_hashtable.h>
+
+// These create a vector and hash table of int that never allocate
+typedef int fixed_int;
+#define VECTOR_TYPE fixed_int
+#define VECTOR_STATIC_CAPACITY 4
+#include <srxk_vector.h>
+#define HT_TYPE fixed_int
+#define HT_EMPTYVALUE -1
+#define HT_STATIC_CAPACITY 8
+#define HT_STATIC_KEYLEN 8
+#include <srxk_hashtable.h>
+
+// These create a vector of double and a gap buffer of char that stay 64 byte
+// aligned
+typedef double adouble;
+#define VECTOR_TYPE adouble
+#define VECTOR_ALIGN 64
+#include <srxk_vector.h>
+typedef char achar;
+#define GAPBUFFER_TYPE achar
+#define GAPBUFFER_ALIGN 64
+#include <srxk_gapbuffer.h>
+
 #define GAPBUFFER_TYPE char
 #include <srxk_gapbuffer.h>
 
+// This creates a deque of struct mystruct, stored inline
+typedef struct mystruct mystruct;
+#define DEQUE_TYPE mystruct
+#include <srxk_deque.h>
+
 #include <stdio.h>
 
 void test_hashtable (void);
 void test_vector (void);
 void test_gapbuffer (void);
+void test_deque (void);
+void test_heap (void);
+void test_static (void);
+void test_align (void);
+
+#ifdef SRXK_TRACK_ALLOC
+void test_alloc (void);
+#endif // SRXK_TRACK_ALLOC
 
 int main (void)
 {
@@ -40,6 +112,18 @@ int main (void)
 	test_hashtable();
 	printf("\n\n/*****GAP BUFFER TEST*****\\\n");
 	test_gapbuffer();
+	printf("\n\n/*****DEQUE TEST*****\\\n");
+	test_deque();
+	printf("\n\n/*****HEAP TEST*****\\\n");
+	test_heap();
+	printf("\n\n/*****STATIC TEST*****\\\n");
+	test_static();
+	printf("\n\n/*****ALIGN TEST*****\\\n");
+	test_align();
+#ifdef SRXK_TRACK_ALLOC
+	printf("\n\n/*****ALLOC TEST*****\\\n");
+	test_alloc();
+#endif // SRXK_TRACK_ALLOC
 	return 0;
 }
 
@@ -60,7 +144,75 @@ void test_hashtable (void)
 		printf("no data\n");
 	else 
 		printf("%s\n", s);
-	
+	ht_string_free(ht);
+
+	// Storing the value a key already has keeps it alive, a new one frees it
+	ht_owned *ho = ht_owned_new();
+	owned o = strdup("kept");
+	ht_owned_insert(ho, "k", o);
+	ht_owned_insert(ho, "k", o);
+	printf("%s ", ht_owned_search(ho, "k"));
+	ht_owned_insert(ho, "k", strdup("replaced"));
+	printf("%s\n", ht_owned_search(ho, "k"));
+	ht_owned_free(ho);
+
+	// Keep "a" hot while filling a cache of 3, it should never be evicted
+	ht_int *c = ht_int_cache_new(3, 0);
+	const char *keys[] = {"a", "b", "c", "d", "e", "f"};
+	for (int i = 0; i < 6; ++i)
+	{
+		ht_int_insert(c, keys[i], i + 1);
+		ht_int_search(c, "a");
+	}
+	printf("%d %d %d\n", c->count, ht_int_search(c, "a"),
+			ht_int_search(c, "b"));
+	printf("hits %ld misses %ld evictions %ld\n", c->hits, c->misses,
+			c->evictions);
+	ht_int_free(c);
+
+	// Growing a value past the byte budget evicts the other item, not it
+	size_t item = sizeof(ht_int_item) + 2;
+	c = ht_int_cache_new(0, item * 3);
+	ht_int_insert(c, "a", 1);
+	ht_int_insert(c, "b", 1);
+	ht_int_insert(c, "a", (int)item + 10);
+	printf("%d %d %d %d\n", c->count, ht_int_search(c, "a") == (int)item + 10,
+			ht_int_search(c, "b"), c->bytes <= c->max_bytes);
+	ht_int_free(c);
+
+	// Misses are answered by the filter, which can be copied out on its own
+	ht_double *hd = ht_double_new();
+	char key[16];
+	for (int i = 0; i < 1000; ++i)
+	{
+		snprintf(key, sizeof(key), "key%d", i);
+		ht_double_insert(hd, key, i * 0.5);
+	}
+	ht_double_delete(hd, "key10");
+	printf("%.1f %.1f %.1f\n", ht_double_search(hd, "key999"),
+			ht_double_search(hd, "key10"), ht_double_search(hd, "nope"));
+	size_t size = srxk_bloom_size(hd->filter);
+	unsigned char *saved = malloc(size);
+	srxk_bloom_save(hd->filter, saved);
+	srxk_bloom *copy = srxk_bloom_load(saved, size);
+	int misses = 0;
+	for (int i = 0; i < 1000; ++i)
+	{
+		snprintf(key, sizeof(key), "key%d", i);
+		misses += !srxk_bloom_test(copy, key);
+	}
+	printf("missing from copy %d\n", misses);
+	srxk_bloom_free(copy);
+
+	// A filter saved with another hash count, or cut short, is refused
+	saved[5] ^= 1;
+	copy = srxk_bloom_load(saved, size);
+	printf("%d %d ", copy == NULL, srxk_bloom_err == EINVAL);
+	saved[5] ^= 1;
+	copy = srxk_bloom_load(saved, size - 8);
+	printf("%d\n", copy == NULL);
+	free(saved);
+	ht_double_free(hd);
 }
 
 void test_vector (void)
@@ -89,5 +241,312 @@ void test_vector (void)
 
 void test_gapbuffer(void)
 {
+	// Insert a few characters, move around and read them back
 	gb_char *gb = gb_char_new(10);
+	gb_char_inserts(gb, "hello", 5);
+	gb_char_left(gb);
+	gb_char_left(gb);
+	gb_char_insert(gb, '_');
+	for (int i = 0; i < gb->len - gb->gap_len; ++i)
+		printf("%c", gb_char_index(gb, i));
+	printf("\n");
+	gb_char_free(gb);
+
+	// Type, backspace, then undo and redo it all
+	gb = gb_char_new(10);
+	gb_char_journal(gb, 4096);
+	for (const char *c = "undo me"; *c; ++c)
+		gb_char_insert(gb, *c);
+	gb_char_delete(gb);
+	gb_char_delete(gb);
+	gb_char_move(gb, 0);
+	gb_char_inserts(gb, "> ", 2);
+	while (gb_char_undo(gb))
+		printf("%d ", gb->len - gb->gap_len);
+	while (gb_char_redo(gb))
+		printf("%d ", gb->len - gb->gap_len);
+	printf("\n");
+	for (int i = 0; i < gb->len - gb->gap_len; ++i)
+		printf("%c", gb_char_index(gb, i));
+	printf("\n");
+
+	// A paste bigger then the cap isn't kept, and the journal doesn't hold
+	// on to more memory then the cap
+	gb_char_journal(gb, 256);
+	char *paste = calloc(100000, 1);
+	gb_char_inserts(gb, paste, 100000);
+	free(paste);
+	printf("%d %d %d\n", gb->history->count, gb->history->data_cap,
+			gb_char_undo(gb));
+	gb_char_free(gb);
+
+	// An old ENOMEM left in gb_char_err doesn't stop the next grow
+	gb = gb_char_new(1);
+	gb_char_err = ENOMEM;
+	gb_char_inserts(gb, "grows", 5);
+	gb_char_insert(gb, '!');
+	printf("%d\n", gb->len - gb->gap_len);
+	gb_char_free(gb);
+	gb_char_err = 0;
+
+	// Shrinking the cap while there are undone edits drops them all
+	gb = gb_char_new(10);
+	gb_char_journal(gb, 4096);
+	for (int i = 0; i < 20; ++i)
+	{
+		gb_char_insert(gb, 'a' + i);
+		gb_char_seal(gb);
+	}
+	for (int i = 0; i < 15; ++i)
+		gb_char_undo(gb);
+	gb_char_journal(gb, 64);
+	printf("%d %d %d %d\n", gb->history->count, gb->history->applied,
+			gb_char_undo(gb), gb->len - gb->gap_len);
+	gb_char_free(gb);
+
+	// Replace every "cat" in one batch, out of order, then undo it as one
+	gb = gb_char_new(4);
+	gb_char_journal(gb, 4096);
+	gb_char_inserts(gb, "cat scat cat", 12);
+	gb_char_move(gb, 0);
+	gb_char_edit edits[] = {{9, 3, "dog", 3}, {0, 3, "a dog", 5}, {5, 3, "", 0},
+			{4, 0, "!", 1}};
+	if (gb_char_apply_edits(gb, edits, 4) < 0)
+		printf("apply_edits failed %d\n", gb_char_err);
+	for (int i = 0; i < gb->len - gb->gap_len; ++i)
+		printf("%c", gb_char_index(gb, i));
+	printf(" %d\n", gb->gap_strt);
+	gb_char_edit overlap[] = {{0, 5, "x", 1}, {3, 1, "y", 1}};
+	int rv = gb_char_apply_edits(gb, overlap, 2);
+	printf("%d %d\n", rv, gb_char_err);
+	gb_char_undo(gb);
+	for (int i = 0; i < gb->len - gb->gap_len; ++i)
+		printf("%c", gb_char_index(gb, i));
+	printf("\n");
+	gb_char_free(gb);
+
+	// Write a temp file, map it, edit it and save it back
+	char path[] = "srxk_gb_XXXXXX";
+	int fd = mkstemp(path);
+	if (fd < 0) {
+		printf("mkstemp failed\n");
+		return; }
+	write(fd, "mapped file", 11);
+	close(fd);
+
+	gb = gb_char_open_file(path);
+	if (gb == NULL) {
+		printf("open_file failed %d\n", gb_char_err);
+		unlink(path);
+		return; }
+	gb_char_inserts(gb, " saved", 6);
+	for (int i = 0; i < 6; ++i)
+		gb_char_left(gb);
+	gb_char_insert(gb, '!');
+	if (gb_char_save(gb, path) < 0)
+		printf("save failed %d\n", gb_char_err);
+	gb_char_free(gb);
+
+	char out[32] = {0};
+	fd = open(path, O_RDONLY);
+	read(fd, out, sizeof(out) - 1);
+	close(fd);
+	printf("%s\n", out);
+
+	// The first move in a freshly opened file places the gap without copying
+	gb = gb_char_open_file(path);
+	if (gb == NULL) {
+		printf("open_file failed %d\n", gb_char_err);
+		unlink(path);
+		return; }
+	gb_char_move(gb, 6);
+	gb_char_inserts(gb, "d,", 2);
+	for (int i = 0; i < gb->len - gb->gap_len; ++i)
+		printf("%c", gb_char_index(gb, i));
+	printf("\n");
+
+	// Saving through a symlink replaces the file, the link stays a link
+	char link[sizeof(path) + 5];
+	snprintf(link, sizeof(link), "%s.link", path);
+	symlink(path, link);
+	gb_char_save(gb, link);
+	gb_char_free(gb);
+	struct stat st;
+	lstat(link, &st);
+	printf("%d ", S_ISLNK(st.st_mode));
+	stat(path, &st);
+	printf("%d\n", (int)st.st_size);
+	unlink(link);
+	unlink(path);
+}
+
+void test_deque(void)
+{
+	// Push to both ends, a pointer to the first element must never move
+	deque_mystruct *d = deque_mystruct_new();
+	deque_mystruct_push_back(d, (mystruct){0, "middle"});
+	mystruct *first = deque_mystruct_at(d, 0);
+	for (int i = 1; i <= 1000; ++i)
+	{
+		deque_mystruct_push_back(d, (mystruct){i, "back"});
+		deque_mystruct_push_front(d, (mystruct){-i, "front"});
+	}
+	printf("%d %s %d\n", d->len, first->str,
+			first == deque_mystruct_at(d, 1000));
+	printf("%d %d\n", deque_mystruct_pop_front(d).x,
+			deque_mystruct_pop_back(d).x);
+	printf("%d %s\n", deque_mystruct_at(d, 0)->x,
+			deque_mystruct_at(d, d->len - 1)->str);
+	deque_mystruct_free(d);
+}
+
+void test_heap(void)
+{
+	// Heapify an existing vector, then pop it back out in order
+	vec_int *v = vec_int_new();
+	for (int i = 0; i < 20; ++i)
+		vec_int_push(v, (i * 7) % 20);
+	heap_int_heapify(v);
+	heap_int_push(v, -5);
+	printf("%d %d\n", heap_int_push_pop(v, -10), heap_int_replace_top(v, 50));
+	heap_int_decrease(v, v->len - 1, -1);
+	heap_int_remove(v, 3);
+	while (v->len > 0)
+		printf("%d ", heap_int_pop(v));
+	printf("\n");
+	vec_int_free(v);
+
+	// Already in order, so heapify moves nothing but still has to record
+	// every index, then decrease a leaf through its index
+	struct task tasks[20];
+	vec_task_ptr *tv = vec_task_ptr_new();
+	for (int i = 0; i < 20; ++i)
+	{
+		tasks[i].key = i;
+		tasks[i].idx = -1;
+		vec_task_ptr_push(tv, &tasks[i]);
+	}
+	heap_task_ptr_heapify(tv);
+	int stale = 0;
+	for (int i = 0; i < 20; ++i)
+		stale += tv->data[tasks[i].idx] != &tasks[i];
+	tasks[19].key = -1;
+	heap_task_ptr_decrease(tv, tasks[19].idx, &tasks[19]);
+	printf("%d %d", stale, heap_task_ptr_top(tv)->key);
+	while (tv->len > 0)
+		printf(" %d", heap_task_ptr_pop(tv)->key);
+	printf("\n");
+	vec_task_ptr_free(tv);
+}
+
+void test_static(void)
+{
+	// The fifth push doesn't fit
+	vec_fixed_int v;
+	vec_fixed_int_init(&v);
+	for (int i = 0; i < 5; ++i)
+		if (vec_fixed_int_push(&v, i) == NULL)
+			printf("full %d ", vec_fixed_int_err == ENOSPC);
+	printf("%d %d\n", v.len, vec_fixed_int_last(&v));
+	vec_fixed_int_reset(&v);
+	printf("%d\n", v.len);
+
+	// Fill the table, then make room by deleting
+	ht_fixed_int ht;
+	ht_fixed_int_init(&ht);
+	char key[16];
+	for (int i = 0; i < 9; ++i)
+	{
+		snprintf(key, sizeof(key), "k%d", i);
+		ht_fixed_int_insert(&ht, key, i);
+	}
+	printf("%d %d %d\n", ht.count, ht_fixed_int_err == ENOSPC,
+			ht_fixed_int_search(&ht, "k7"));
+	ht_fixed_int_insert(&ht, "too long", 1);
+	printf("%d\n", ht_fixed_int_err == ENAMETOOLONG);
+	ht_fixed_int_delete(&ht, "k3");
+	ht_fixed_int_insert(&ht, "k8", 8);
+	printf("%d %d %d\n", ht.count, ht_fixed_int_search(&ht, "k3"),
+			ht_fixed_int_search(&ht, "k8"));
+
+	// Reset empties it without touching the buckets
+	ht_fixed_int_reset(&ht);
+	printf("%d %d ", ht.count, ht_fixed_int_search(&ht, "k8"));
+	ht_fixed_int_insert(&ht, "k8", 80);
+	printf("%d\n", ht_fixed_int_search(&ht, "k8"));
+
+	// Churning through keys rehashes the deleted buckets away in place
+	for (int i = 0; i < 100; ++i)
+	{
+		snprintf(key, sizeof(key), "c%d", i);
+		ht_fixed_int_insert(&ht, key, i);
+		ht_fixed_int_delete(&ht, key);
+	}
+	printf("%d %d %d\n", ht.count, ht.deleted <= (8 - ht.count) / 2,
+			ht_fixed_int_search(&ht, "k8"));
+}
+
+void test_align(void)
+{
+	// The data has to stay aligned every time the vector grows
+	vec_adouble *v = vec_adouble_new();
+	int misaligned = 0;
+	for (int i = 0; i < 100000; ++i)
+	{
+		vec_adouble_push(v, 1.0);
+		misaligned += ((uintptr_t)v->data & 63) != 0 || v->capacity % 8 != 0;
+	}
+	vec_adouble_pop(v);
+	// Sum whole cache lines, the padding is zero so it doesn't add anything
+	int n = vec_adouble_pad(v, 0.0);
+	const adouble *SRXK_RESTRICT d = vec_adouble_data(v);
+	double sum = 0;
+	for (int i = 0; i < n; ++i)
+		sum += d[i];
+	printf("%d %d %.0f\n", misaligned, n, sum);
+	vec_adouble_free(v);
+
+	gb_achar *gb = gb_achar_new(3);
+	for (int i = 0; i < 1000; ++i)
+	{
+		gb_achar_insert(gb, 'a' + i % 26);
+		if (i % 7 == 0)
+			gb_achar_left(gb);
+		misaligned += ((uintptr_t)gb_achar_data(gb) & 63) != 0
+				|| gb->len % 64 != 0;
+	}
+	printf("%d %d %c\n", misaligned, gb->len - gb->gap_len,
+			gb_achar_index(gb, 0));
+	gb_achar_free(gb);
+}
+
+#ifdef SRXK_TRACK_ALLOC
+void test_alloc(void)
+{
+	// Items and keys are counted apart from the buckets
+	ht_string *ht = ht_string_new();
+	char key[16];
+	for (int i = 0; i < 100; ++i)
+	{
+		snprintf(key, sizeof(key), "key%d", i);
+		ht_string_insert(ht, key, "value");
+	}
+	printf("items %zu keys %zu table %zu\n",
+			srxk_alloc_totals[SRXK_ALLOC_HT_ITEM].live,
+			srxk_alloc_totals[SRXK_ALLOC_HT_KEY].live,
+			srxk_alloc_totals[SRXK_ALLOC_HT].live);
+	printf("%d\n", ht_string_memory_usage(ht) == ht->mem.live);
+	ht_string_free(ht);
+
+	// Growing past the first few reallocs copies the old data
+	vec_int *v = vec_int_new();
+	for (int i = 0; i < 1000; ++i)
+		vec_int_push(v, i);
+	printf("%zu %d\n", vec_int_memory_usage(v),
+			v->mem.reallocs > 0 && v->mem.peak == v->mem.live);
+	vec_int_free(v);
+
+	// Every test has freed what it made, so nothing should be live
+	srxk_alloc_report(stdout);
 }
+#endif // SRXK_TRACK_ALLOC
@@ -0,0 +1,107 @@
+// Tests for srxk.hpp, the output is read the same way as ./test
+#include <srxk.hpp>
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+void test_vector(void);
+void test_hashtable(void);
+void test_gapbuffer(void);
+
+int main(void)
+{
+	std::printf("/*****C++ VECTOR TEST*****\\\n");
+	test_vector();
+	std::printf("\n\n/*****C++ HASH TABLE TEST*****\\\n");
+	test_hashtable();
+	std::printf("\n\n/*****C++ GAP BUFFER TEST*****\\\n");
+	test_gapbuffer();
+	return 0;
+}
+
+void test_vector(void)
+{
+	// Strings are built in place and moved when the vector grows
+	srxk::vector<std::string> v;
+	for (int i = 0; i < 100; ++i)
+		v.emplace_back(std::to_string(i));
+	v.push_back(v[0]);
+	std::printf("%zu %s %s\n", v.size(), v[99].c_str(), v.last().c_str());
+	std::printf("%s\n", v.pop_back().c_str());
+
+	// Ownership moves, the old vector is left empty
+	srxk::vector<std::string> w = std::move(v);
+	std::printf("%zu %zu\n", v.size(), w.size());
+
+	srxk::vector<int> iv;
+	for (int i = 0; i < 10; ++i)
+		iv.push_back(i * i);
+	int sum = 0;
+	for (int x : iv)
+		sum += x;
+	std::printf("%d\n", sum);
+}
+
+void test_hashtable(void)
+{
+	srxk::hashtable<std::string, std::string> ht;
+	ht.try_emplace("test", "gamer1");
+	ht.try_emplace("update", "gamer2");
+	ht.insert_or_assign("update", "gamer2_updated");
+	// The value isn't touched if the key is already there
+	bool inserted = ht.try_emplace("test", "ignored").second;
+
+	std::printf("%s %d\n", ht.find(std::string_view("test"))->c_str(),
+			inserted);
+	std::printf("%s\n", ht.find("update")->c_str());
+
+	ht.try_emplace(std::string("delete"), 3, 'x');
+	std::printf("%s\n", ht.find("delete")->c_str());
+	ht.erase(std::string_view("delete"));
+	std::printf("%s\n", ht.contains("delete") ? "found" : "no data");
+
+	// Past the first resize with tombstones in the way
+	srxk::hashtable<int, int> ih;
+	for (int i = 0; i < 1000; ++i)
+		ih.try_emplace(i, i * 2);
+	for (int i = 0; i < 1000; i += 2)
+		ih.erase(i);
+	int found = 0;
+	for (int i = 0; i < 1000; ++i)
+		found += ih.find(i) != nullptr;
+	std::printf("%zu %d %d\n", ih.size(), found, *ih.find(999));
+
+	// The moved from table is empty but can still be used
+	srxk::hashtable<int, int> moved = std::move(ih);
+	std::printf("%d %d %d ", ih.find(1) != nullptr, ih.contains(1),
+			ih.erase(1));
+	ih.insert_or_assign(7, 49);
+	std::printf("%zu %d %zu\n", ih.size(), *ih.find(7), moved.size());
+}
+
+void test_gapbuffer(void)
+{
+	srxk::gapbuffer<char> gb;
+	gb.insert("hello", 5);
+	gb.left();
+	gb.left();
+	gb.insert('_');
+	for (std::size_t i = 0; i < gb.size(); ++i)
+		std::printf("%c", gb[i]);
+	std::printf("\n");
+
+	// Non trivial elements move across the gap
+	srxk::gapbuffer<std::string> lines(2);
+	lines.emplace("one");
+	lines.emplace("three");
+	lines.left();
+	lines.emplace("two");
+	lines.move(0);
+	lines.emplace("zero");
+	lines.move(lines.size());
+	lines.erase();
+	for (std::size_t i = 0; i < lines.size(); ++i)
+		std::printf("%s ", lines[i].c_str());
+	std::printf("\n");
+}